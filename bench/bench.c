@@ -0,0 +1,496 @@
+/**
+ * Benchmarks for parser registration, parse_args and parse_args_batch
+ * throughput, getter latency and allocations per parse. Before timing
+ * anything, every parsing path is checked against plain parse_args on the
+ * same command lines, and the peak RSS is reported at the end.
+ *
+ * Build and run:
+ * cc -O2 -o bench bench/bench.c && ./bench
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/resource.h>
+
+#include "../myargs.h"
+
+static size_t allocations = 0;
+
+static void *bench_malloc(size_t size)
+{
+    allocations++;
+    return malloc(size);
+}
+
+static void *bench_realloc(void *ptr, size_t size)
+{
+    allocations++;
+    return realloc(ptr, size);
+}
+
+#define OPTIONS 300
+
+static char names[OPTIONS][32];
+static volatile size_t sink;
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void report(const char *name, long iterations, double ns, double per, const char *unit)
+{
+    printf("%-36s %10ld %12.1f ns/op %12.1f %s\n", name, iterations, ns / iterations, per, unit);
+}
+
+/**
+ * Registers OPTIONS arguments: kwargs with a symbol, flags and a few nargs args.
+ */
+static void build_parser(ArgumentParser *parser, ArgumentHandle *handles)
+{
+    init_parser(parser, "bench", "Usage: bench [options]", "Benchmark parser.", "");
+    for (int i = 0; i < OPTIONS; i++)
+    {
+        char sym = i < 26 ? (char)('a' + i) : i < 52 ? (char)('A' + i - 26) : 0;
+        ArgumentHandle handle;
+        if (i % 3 == 0)
+            handle = add_flag(parser, sym, names[i], "A flag");
+        else if (i % 50 == 1)
+            handle = add_arg(parser, sym, names[i], 0, NARGS_ZERO_OR_MORE, NULL, "Some files");
+        else
+            handle = add_kwarg(parser, sym, names[i], 0, "default", "A keyword argument");
+        if (handles)
+            handles[i] = handle;
+    }
+}
+
+static void bench_registration(void)
+{
+    long iterations = 2000;
+    size_t before = allocations;
+    double start = now_ns();
+    for (long n = 0; n < iterations; n++)
+    {
+        ArgumentParser parser;
+        build_parser(&parser, NULL);
+        free_parser(&parser);
+    }
+    double elapsed = now_ns() - start;
+    report("init_parser + 300 x add_*", iterations, elapsed, (double)(allocations - before) / iterations, "allocs/op");
+}
+
+static void bench_schema(void)
+{
+    ArgumentParser parser;
+    build_parser(&parser, NULL);
+    freeze_parser(&parser);
+    size_t size = save_schema(&parser, NULL, 0);
+    void *snapshot = malloc(size);
+    save_schema(&parser, snapshot, size);
+    free_parser(&parser);
+
+    long iterations = 20000;
+    size_t before = allocations;
+    double start = now_ns();
+    for (long n = 0; n < iterations; n++)
+    {
+        ArgumentParser loaded;
+        load_schema(&loaded, snapshot, size);
+        sink += (size_t)loaded.count;
+        free_parser(&loaded);
+    }
+    double elapsed = now_ns() - start;
+    report("load_schema 300 options", iterations, elapsed, (double)(allocations - before) / iterations, "allocs/op");
+    free(snapshot);
+}
+
+/**
+ * Builds a synthetic argv of count tokens mixing --long, --long=value,
+ * short bundles and -x=value forms.
+ */
+static char **make_argv(int count)
+{
+    char **argv = (char **)calloc(count + 1, sizeof(char *));
+    argv[0] = strdup("bench");
+    for (int i = 1; i <= count; i++)
+    {
+        char token[64];
+        int option = (i * 7) % OPTIONS;
+        switch (i % 4)
+        {
+        case 0:
+            snprintf(token, sizeof(token), "--%s", names[option - option % 3]);
+            break;
+        case 1:
+            snprintf(token, sizeof(token), "--%s=value%d", names[option % 3 ? option : option + 2], i);
+            break;
+        case 2:
+            snprintf(token, sizeof(token), "-adgj");
+            break;
+        default:
+            snprintf(token, sizeof(token), "-b=%d", i);
+            break;
+        }
+        argv[i] = strdup(token);
+    }
+    return argv;
+}
+
+static void bench_state(void)
+{
+    ArgumentParser parser;
+    build_parser(&parser, NULL);
+    char **argv = make_argv(1000);
+    parse_args(&parser, 1001, argv);
+    size_t size = save_state(&parser, NULL, NULL, 0);
+    void *region = malloc(size);
+    save_state(&parser, NULL, region, size);
+    free_parser(&parser);
+    for (int i = 0; i <= 1000; i++)
+        free(argv[i]);
+    free(argv);
+
+    long iterations = 20000;
+    size_t before = allocations;
+    double start = now_ns();
+    for (long n = 0; n < iterations; n++)
+    {
+        ArgumentParser loaded;
+        load_state(&loaded, region, size);
+        sink += (size_t)loaded.count;
+        free_parser(&loaded);
+    }
+    double elapsed = now_ns() - start;
+    report("load_state 300 options, 1000 tokens", iterations, elapsed, (double)(allocations - before) / iterations, "allocs/op");
+    free(region);
+}
+
+/**
+ * Compares one argument's value in a result with the reference parse.
+ */
+static bool same_value(const ArgumentResult *reference, const ArgumentResult *result, ArgumentHandle handle)
+{
+    const char *expected = get_result_value(reference, handle);
+    const char *actual = get_result_value(result, handle);
+    int expected_count, actual_count;
+    char **expected_values = get_result_values(reference, handle, &expected_count);
+    char **actual_values = get_result_values(result, handle, &actual_count);
+    if ((expected == NULL) != (actual == NULL) || (expected && strcmp(expected, actual) != 0) || expected_count != actual_count)
+        return false;
+    for (int i = 0; i < expected_count; i++)
+    {
+        if (strcmp(expected_values[i], actual_values[i]) != 0)
+            return false;
+    }
+    return true;
+}
+
+/**
+ * Parses the same command lines with zero-copy, lazy, frozen, batch,
+ * snapshot and streamed parsers, and loads the reference's saved state, and checks that each agrees with plain parse_args.
+ *
+ * @return The number of values that disagree.
+ */
+static int check_engines(void)
+{
+    int mismatches = 0;
+    for (int tokens = 1; tokens <= 1000; tokens *= 10)
+    {
+        char **argv = make_argv(tokens);
+        const char *const *args = (const char *const *)argv;
+
+        ArgumentParser reference, zero_copy, lazy, frozen;
+        build_parser(&reference, NULL);
+        build_parser(&zero_copy, NULL);
+        build_parser(&lazy, NULL);
+        build_parser(&frozen, NULL);
+        zero_copy.zero_copy = true;
+        lazy.lazy = true;
+        parse_args(&reference, tokens + 1, argv);
+        parse_args(&zero_copy, tokens + 1, argv);
+        parse_args(&lazy, tokens + 1, argv);
+
+        const ArgumentParser *schema = freeze_parser(&frozen);
+        ArgumentResult into;
+        init_result(&into, schema, NULL, 0);
+        parse_args_into(schema, &into, tokens + 1, args);
+
+        size_t size = save_schema(schema, NULL, 0);
+        void *snapshot = malloc(size);
+        save_schema(schema, snapshot, size);
+        ArgumentParser loaded;
+        load_schema(&loaded, snapshot, size);
+        ArgumentResult from_snapshot;
+        init_result(&from_snapshot, &loaded, NULL, 0);
+        parse_args_into(&loaded, &from_snapshot, tokens + 1, args);
+
+        size_t state_size = save_state(&reference, NULL, NULL, 0);
+        void *region = malloc(state_size);
+        save_state(&reference, NULL, region, state_size);
+        ArgumentParser state;
+        load_state(&state, region, state_size);
+
+        ArgumentResult streamed;
+        init_result(&streamed, schema, NULL, 0);
+        for (int i = 1; i <= tokens; i++)
+            parser_feed_into(schema, &streamed, argv[i], strlen(argv[i]));
+        parser_finish_into(schema, &streamed);
+
+        const int argcs[2] = {tokens + 1, tokens + 1};
+        const char *const *argvs[2] = {args, args};
+        ArgumentBatch batch;
+        init_batch(&batch);
+        parse_args_batch(schema, 2, argcs, argvs, &batch);
+
+        for (ArgumentHandle handle = 0; handle < reference.count; handle++)
+        {
+            bool same = same_value(&reference.result, &zero_copy.result, handle) && same_value(&reference.result, &lazy.result, handle) && same_value(&reference.result, &into, handle) && same_value(&reference.result, &from_snapshot, handle) && same_value(&reference.result, &streamed, handle) && same_value(&reference.result, &state.result, handle);
+            const char *expected = get_result_value(&reference.result, handle);
+            const char *row = batch.column[handle].values[1];
+            same = same && (expected == NULL) == (row == NULL) && (!expected || strcmp(expected, row) == 0);
+            if (!same)
+            {
+                printf("mismatch: %s with %d tokens\n", reference.arguments[handle].name, tokens);
+                mismatches++;
+            }
+        }
+
+        free_batch(&batch);
+        free_result(&streamed);
+        free_parser(&state);
+        free(region);
+        free_result(&from_snapshot);
+        free_parser(&loaded);
+        free(snapshot);
+        free_result(&into);
+        free_parser(&frozen);
+        free_parser(&lazy);
+        free_parser(&zero_copy);
+        free_parser(&reference);
+        for (int i = 0; i <= tokens; i++)
+            free(argv[i]);
+        free(argv);
+    }
+    return mismatches;
+}
+
+static void bench_parse(int tokens, bool zero_copy, bool lazy)
+{
+    ArgumentParser parser;
+    build_parser(&parser, NULL);
+    parser.zero_copy = zero_copy;
+    parser.lazy = lazy;
+    char **argv = make_argv(tokens);
+
+    long iterations = 2000000 / tokens + 10;
+    parse_args(&parser, tokens + 1, argv); // warm up the value pool
+    size_t before = allocations;
+    double start = now_ns();
+    for (long n = 0; n < iterations; n++)
+    {
+        reset_parser_values(&parser);
+        parse_args(&parser, tokens + 1, argv);
+    }
+    double elapsed = now_ns() - start;
+
+    char name[64];
+    snprintf(name, sizeof(name), "parse_args %d tokens%s%s", tokens, zero_copy ? " zero-copy" : "", lazy ? " lazy" : "");
+    report(name, iterations, elapsed, (double)(allocations - before) / iterations, "allocs/op");
+    snprintf(name, sizeof(name), "  per token (%d tokens)", tokens);
+    report(name, iterations * tokens, elapsed, tokens * iterations / (elapsed / 1e9) / 1e6, "Mtokens/s");
+
+    for (int i = 0; i <= tokens; i++)
+        free(argv[i]);
+    free(argv);
+    free_parser(&parser);
+}
+
+static void bench_feed(int tokens)
+{
+    ArgumentParser parser;
+    build_parser(&parser, NULL);
+    char **argv = make_argv(tokens);
+    size_t *lengths = (size_t *)calloc(tokens + 1, sizeof(size_t));
+    for (int i = 1; i <= tokens; i++)
+        lengths[i] = strlen(argv[i]);
+
+    long iterations = 2000000 / tokens + 10;
+    size_t before = allocations;
+    double start = now_ns();
+    for (long n = 0; n < iterations; n++)
+    {
+        reset_parser_values(&parser);
+        for (int i = 1; i <= tokens; i++)
+            parser_feed(&parser, argv[i], lengths[i]);
+        parser_finish(&parser);
+    }
+    double elapsed = now_ns() - start;
+
+    char name[64];
+    snprintf(name, sizeof(name), "parser_feed %d tokens", tokens);
+    report(name, iterations, elapsed, (double)(allocations - before) / iterations, "allocs/op");
+
+    free(lengths);
+    for (int i = 0; i <= tokens; i++)
+        free(argv[i]);
+    free(argv);
+    free_parser(&parser);
+}
+
+static void bench_errors(void)
+{
+    ArgumentParser parser;
+    build_parser(&parser, NULL);
+    parser.exit_on_error = false;
+    // a malformed request: unknown, misspelt and ambiguous options
+    char *argv[] = {(char *)"bench", (char *)"--nope", (char *)"--optoin-4=x", (char *)"--option-1", (char *)"-ad", (char *)"--bogus=1"};
+    int argc = sizeof(argv) / sizeof(argv[0]);
+
+    long iterations = 200000;
+    parse_args(&parser, argc, argv);
+    size_t before = allocations;
+    double start = now_ns();
+    for (long n = 0; n < iterations; n++)
+    {
+        reset_parser_values(&parser);
+        sink += parse_args(&parser, argc, argv);
+    }
+    report("parse_args rejecting 3 bad options", iterations, now_ns() - start, (double)(allocations - before) / iterations, "allocs/op");
+    free_parser(&parser);
+}
+
+static void bench_bundles(void)
+{
+    ArgumentParser parser;
+    build_parser(&parser, NULL);
+    // flags sit on every third symbol, c is a kwarg with its value glued on
+    char *argv[] = {(char *)"bench", (char *)"-adgjmpsvy", (char *)"-BEHKNQTWZ", (char *)"-adgc5", (char *)"-vye=hello"};
+    int argc = sizeof(argv) / sizeof(argv[0]);
+
+    long iterations = 1000000;
+    parse_args(&parser, argc, argv);
+    size_t before = allocations;
+    double start = now_ns();
+    for (long n = 0; n < iterations; n++)
+    {
+        reset_parser_values(&parser);
+        parse_args(&parser, argc, argv);
+    }
+    report("parse_args short bundles", iterations, now_ns() - start, (double)(allocations - before) / iterations, "allocs/op");
+    free_parser(&parser);
+}
+
+static void bench_batch(int rows, int tokens)
+{
+    ArgumentParser parser;
+    build_parser(&parser, NULL);
+    char **argv = make_argv(tokens);
+    int *argcs = (int *)calloc(rows, sizeof(int));
+    const char *const **argvs = (const char *const **)calloc(rows, sizeof(char **));
+    for (int i = 0; i < rows; i++)
+    {
+        argcs[i] = tokens + 1;
+        argvs[i] = (const char *const *)argv;
+    }
+
+    ArgumentBatch batch;
+    init_batch(&batch);
+    parse_args_batch(&parser, rows, argcs, argvs, &batch); // warm up the arena
+    long iterations = 20;
+    size_t before = allocations;
+    double start = now_ns();
+    for (long n = 0; n < iterations; n++)
+        parse_args_batch(&parser, rows, argcs, argvs, &batch);
+    double elapsed = now_ns() - start;
+
+    char name[64];
+    snprintf(name, sizeof(name), "parse_args_batch %d x %d tokens", rows, tokens);
+    report(name, iterations, elapsed, (double)(allocations - before) / iterations, "allocs/op");
+    snprintf(name, sizeof(name), "  per row (%d tokens)", tokens);
+    report(name, iterations * rows, elapsed, 0, "");
+
+    free_batch(&batch);
+    free(argvs);
+    free(argcs);
+    for (int i = 0; i <= tokens; i++)
+        free(argv[i]);
+    free(argv);
+    free_parser(&parser);
+}
+
+static void bench_getters(void)
+{
+    ArgumentParser parser;
+    ArgumentHandle handles[OPTIONS];
+    build_parser(&parser, handles);
+    char *argv[] = {(char *)"bench"};
+    parse_args(&parser, 1, argv);
+
+    long iterations = 5000000;
+    double start = now_ns();
+    for (long n = 0; n < iterations; n++)
+        sink += (size_t)get_kwarg(&parser, names[(n % (OPTIONS / 3)) * 3 + 2]);
+    report("get_kwarg by name", iterations, now_ns() - start, 0, "");
+
+    start = now_ns();
+    for (long n = 0; n < iterations; n++)
+        sink += (size_t)get_kwarg_h(&parser, handles[(n % (OPTIONS / 3)) * 3 + 2]);
+    report("get_kwarg_h by handle", iterations, now_ns() - start, 0, "");
+
+    start = now_ns();
+    for (long n = 0; n < iterations; n++)
+        sink += get_flag(&parser, names[(n % (OPTIONS / 3)) * 3]);
+    report("get_flag by name", iterations, now_ns() - start, 0, "");
+
+    start = now_ns();
+    for (long n = 0; n < iterations; n++)
+        sink += get_flag_h(&parser, handles[(n % (OPTIONS / 3)) * 3]);
+    report("get_flag_h by handle", iterations, now_ns() - start, 0, "");
+
+    start = now_ns();
+    for (long n = 0; n < iterations; n++)
+        sink += (size_t)find_arg(&parser, names[(n * 7) % OPTIONS]);
+    report("find_arg", iterations, now_ns() - start, 0, "");
+
+    const ArgumentParser *schema = freeze_parser(&parser);
+    start = now_ns();
+    for (long n = 0; n < iterations; n++)
+        sink += (size_t)find_arg(schema, names[(n * 7) % OPTIONS]);
+    report("find_arg frozen", iterations, now_ns() - start, 0, "");
+
+    free_parser(&parser);
+}
+
+int main(void)
+{
+    // route the parser's allocations through the counters above
+    myargs_set_allocator(bench_malloc, bench_realloc, NULL);
+    for (int i = 0; i < OPTIONS; i++)
+        snprintf(names[i], sizeof(names[i]), "option-%d", i);
+
+    if (check_engines() != 0)
+        return 1;
+
+    printf("%-36s %10s %15s %15s\n", "benchmark", "iterations", "time", "extra");
+    bench_registration();
+    bench_schema();
+    bench_state();
+    for (int tokens = 10; tokens <= 10000; tokens *= 10)
+        bench_parse(tokens, false, false);
+    bench_parse(1000, true, false);
+    bench_parse(1000, false, true);
+    bench_feed(1000);
+    bench_bundles();
+    bench_errors();
+    bench_batch(10000, 10);
+    bench_getters();
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    printf("peak RSS: %ld KiB\n", usage.ru_maxrss);
+    return 0;
+}
@@ -0,0 +1,127 @@
+/**
+ * Stress test for the thread-safety guarantee of freeze_parser: a number of
+ * threads call parse_args_into on one frozen parser at the same time, each
+ * with its own ArgumentResult, on command lines that expand response files.
+ * Every parse is checked against the values each thread expects, and the
+ * total throughput is reported at the end.
+ *
+ * Build and run under ThreadSanitizer, which must report nothing:
+ * cc -g -O1 -fsanitize=thread -pthread -o threads bench/threads.c && ./threads [threads] [iterations]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "../myargs.h"
+
+#define MAX_THREADS 64
+
+static const ArgumentParser *schema;
+static ArgumentHandle count, ratio, verbose, color, files, pair;
+static char inner_path[64], outer_path[64];
+static int iterations = 20000;
+
+static void check(bool ok, long id, int iteration, const char *what)
+{
+    if (!ok)
+    {
+        fprintf(stderr, "thread %ld, iteration %d: wrong %s\n", id, iteration, what);
+        exit(EXIT_FAILURE);
+    }
+}
+
+static void *work(void *data)
+{
+    long id = (long)data;
+    char count_token[32], outer_token[80];
+    snprintf(count_token, sizeof(count_token), "--count=%ld", id);
+    snprintf(outer_token, sizeof(outer_token), "@%s", outer_path);
+    const char *plain[] = {"threads", count_token, "-v", "--files", "a", "b"};
+    const char *response[] = {"threads", count_token, outer_token, "--pair", "x", "y"};
+
+    ArgumentResult result;
+    init_result(&result, schema, NULL, 0);
+    for (int i = 0; i < iterations; i++)
+    {
+        bool file = i & 1;
+        ArgumentStatus status = file ? parse_args_into(schema, &result, 6, response) : parse_args_into(schema, &result, 6, plain);
+        check(status == ARGUMENT_OK, id, i, "status");
+        check(get_result_int(&result, count) == id, id, i, "count");
+        check(get_result_flag(&result, verbose) == !file, id, i, "verbose");
+
+        int n;
+        char **values = get_result_values(&result, files, &n);
+        check(n == 2, id, i, "number of files");
+        check(strcmp(values[0], file ? "inner.txt" : "a") == 0 && strcmp(values[1], file ? "outer.txt" : "b") == 0, id, i, "files");
+        check(strcmp(get_result_value(&result, color), file ? "blue" : "red") == 0, id, i, "color");
+        check(get_result_double(&result, ratio) == (file ? 0.25 : 1.5), id, i, "ratio");
+        values = get_result_values(&result, pair, &n);
+        check(file ? n == 2 && strcmp(values[1], "y") == 0 : n == 0, id, i, "pair");
+    }
+    free_result(&result);
+    return NULL;
+}
+
+static void write_file(char *path, const char *text)
+{
+    strcpy(path, "/tmp/myargs_threadsXXXXXX");
+    int fd = mkstemp(path);
+    if (fd < 0 || write(fd, text, strlen(text)) != (ssize_t)strlen(text))
+    {
+        perror("mkstemp");
+        exit(EXIT_FAILURE);
+    }
+    close(fd);
+}
+
+int main(int argc, char *argv[])
+{
+    int threads = argc > 1 ? atoi(argv[1]) : 8;
+    iterations = argc > 2 ? atoi(argv[2]) : iterations;
+    if (threads < 1 || threads > MAX_THREADS || iterations < 1)
+    {
+        fprintf(stderr, "usage: %s [threads, up to %d] [iterations]\n", argv[0], MAX_THREADS);
+        return EXIT_FAILURE;
+    }
+
+    // the outer response file names the inner one, so both levels are read
+    write_file(inner_path, "'inner.txt'\n\"outer.txt\"\n");
+    char outer[128];
+    snprintf(outer, sizeof(outer), "--color=blue --ratio=0.25\n--files @%s\n", inner_path);
+    write_file(outer_path, outer);
+
+    ArgumentParser parser;
+    init_parser(&parser, "threads", "Usage: threads [options]", "Stress test for parse_args_into.", "");
+    parser.exit_on_error = false;
+    parser.fromfile_prefix_char = '@';
+    count = add_kwarg(&parser, 'c', "count", 0, "0", "A number");
+    set_type(&parser, count, VALUE_INT);
+    ratio = add_kwarg(&parser, 'r', "ratio", 0, "1.5", "A ratio");
+    set_type(&parser, ratio, VALUE_DOUBLE);
+    color = add_kwarg(&parser, 0, "color", 0, "red", "A color");
+    set_choices(&parser, color, "red,green,blue");
+    verbose = add_flag(&parser, 'v', "verbose", "Verbose output");
+    files = add_arg(&parser, 'f', "files", 0, NARGS_ZERO_OR_MORE, NULL, "Input files");
+    pair = add_arg(&parser, 'p', "pair", 0, 2, NULL, "Two values");
+    schema = freeze_parser(&parser);
+
+    pthread_t workers[MAX_THREADS];
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (long i = 0; i < threads; i++)
+        pthread_create(&workers[i], NULL, work, (void *)i);
+    for (int i = 0; i < threads; i++)
+        pthread_join(workers[i], NULL);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    free_parser(&parser);
+    remove(inner_path);
+    remove(outer_path);
+    double seconds = (double)(end.tv_sec - start.tv_sec) + (double)(end.tv_nsec - start.tv_nsec) / 1e9;
+    printf("%d threads x %d parses: %.0f parses/s\n", threads, iterations, (double)threads * iterations / seconds);
+    return EXIT_SUCCESS;
+}
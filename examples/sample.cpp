@@ -13,7 +13,12 @@ int main(int argc, char *argv[])
     parser.AddKwarg('c', "count", 0, NULL, "Number of times");
 
     // Parse the command-line arguments
-    parser.Parse(argc, argv);
+    Expected<void> status = parser.Parse(argc, argv);
+    if (!status)
+    {
+        fprintf(stderr, "%s\n", status.Error().message);
+        return 1;
+    }
 
     // Retrieve the values of the arguments
     int verbose = parser.GetFlag("verbose");
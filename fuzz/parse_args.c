@@ -0,0 +1,302 @@
+/**
+ * libFuzzer target for parse_args. Each input is a command line, one token
+ * per line or per NUL byte, so a /proc/<pid>/cmdline dump without its
+ * program name is a valid input. The command line is parsed by plain
+ * parse_args and by every other engine: zero-copy, lazy, frozen, snapshot,
+ * streamed, batch and a loaded state. The target aborts if any engine
+ * disagrees with parse_args on a status or a value.
+ *
+ * Build and run with libFuzzer, which reports exec/s and RSS as it goes:
+ * clang -g -O1 -fsanitize=fuzzer,address,undefined -o fuzz_parse_args fuzz/parse_args.c
+ * ./fuzz_parse_args -rss_limit_mb=256 fuzz/corpus
+ *
+ * Without libFuzzer, MYARGS_FUZZ_MAIN replays inputs instead. Each one runs
+ * in its own process and gets its exec/s and peak RSS:
+ * cc -g -O1 -fsanitize=address,undefined -DMYARGS_FUZZ_MAIN -o fuzz_parse_args fuzz/parse_args.c
+ * ./fuzz_parse_args $(find fuzz/corpus -type f)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "../myargs.h"
+
+#define MAX_TOKENS 256
+
+static void build_clone(ArgumentParser *clone, void *data)
+{
+    (void)data;
+    add_flag(clone, 'b', "bare", "Make a bare repository");
+    add_kwarg(clone, 'd', "depth", 0, NULL, "Truncate the history");
+}
+
+/**
+ * Registers the schema the corpus is written against: every argument type,
+ * the multi-value counts, a typed and a restricted kwarg and, unless the
+ * parser is to be snapshotted, a subcommand.
+ */
+static void build_parser(ArgumentParser *parser, bool commands)
+{
+    init_parser(parser, "fuzz", NULL, NULL, NULL);
+    parser->exit_on_error = false;
+    ArgumentHandle count = add_kwarg(parser, 'c', "count", 0, "1", "Number of times");
+    set_type(parser, count, VALUE_SIZE);
+    ArgumentHandle color = add_kwarg(parser, 0, "color", 0, NULL, "Output color");
+    set_choices(parser, color, "red,green,blue");
+    ArgumentHandle ratio = add_kwarg(parser, 'r', "ratio", 0, "0.5", "A ratio");
+    set_type(parser, ratio, VALUE_DOUBLE);
+    add_kwarg(parser, 'o', "output", 0, NULL, "Output file");
+    add_kwarg(parser, 0, "output-format", 0, "text", "Output format");
+    add_flag(parser, 'v', "verbose", "Verbose output");
+    add_flag(parser, 'q', "quiet", "Quiet output");
+    add_arg(parser, 'f', "files", 0, NARGS_ZERO_OR_MORE, NULL, "Input files");
+    add_arg(parser, 'i', "include", 0, NARGS_ONE_OR_MORE, NULL, "Include paths");
+    add_arg(parser, 'p', "pair", 0, 2, NULL, "Two values");
+    add_arg(parser, 0, "maybe", 0, NARGS_OPTIONAL, NULL, "An optional value");
+    if (commands)
+        add_command(parser, "clone", "Clone a repository", build_clone, NULL);
+}
+
+/**
+ * Compares one argument's value in a result with the reference parse.
+ */
+static bool same_value(const ArgumentResult *reference, const ArgumentResult *result, ArgumentHandle handle)
+{
+    const char *expected = get_result_value(reference, handle);
+    const char *actual = get_result_value(result, handle);
+    int expected_count, actual_count;
+    char **expected_values = get_result_values(reference, handle, &expected_count);
+    char **actual_values = get_result_values(result, handle, &actual_count);
+    if ((expected == NULL) != (actual == NULL) || (expected && strcmp(expected, actual) != 0) || expected_count != actual_count)
+        return false;
+    if (get_result_int(reference, handle) != get_result_int(result, handle))
+        return false;
+    for (int i = 0; i < expected_count; i++)
+    {
+        if (strcmp(expected_values[i], actual_values[i]) != 0)
+            return false;
+    }
+    return true;
+}
+
+/**
+ * Compares the errors of two results by status, in any order: a lazy parse
+ * reports an invalid value only once it is read.
+ */
+static bool same_errors(const ArgumentResult *reference, const ArgumentResult *result)
+{
+    int counts[ARGUMENT_ERROR + 1] = {0};
+    int expected_count, actual_count;
+    const ArgumentError_t *expected = get_result_errors(reference, &expected_count);
+    const ArgumentError_t *actual = get_result_errors(result, &actual_count);
+    // once errors are dropped, which ones were kept depends on the order
+    if (reference->diagnostics.dropped || result->diagnostics.dropped)
+        return expected_count + reference->diagnostics.dropped == actual_count + result->diagnostics.dropped;
+    for (int i = 0; i < expected_count; i++)
+        counts[expected[i].status]++;
+    for (int i = 0; i < actual_count; i++)
+        counts[actual[i].status]--;
+    for (int k = 0; k <= ARGUMENT_ERROR; k++)
+    {
+        if (counts[k] != 0)
+            return false;
+    }
+    return true;
+}
+
+static void check(bool same, const char *engine, const ArgumentParser *parser, ArgumentHandle handle)
+{
+    if (same)
+        return;
+    fprintf(stderr, "%s disagrees with parse_args on %s\n", engine, handle >= 0 ? parser->arguments[handle].name : "the status");
+    abort();
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    // split the input into tokens in a copy that stays alive for zero-copy
+    char *text = (char *)malloc(size + 1);
+    memcpy(text, data, size);
+    text[size] = '\0';
+    const char *argv[MAX_TOKENS + 1];
+    int argc = 0;
+    argv[argc++] = "fuzz";
+    for (char *token = text; token <= text + size && argc <= MAX_TOKENS;)
+    {
+        char *end = token;
+        while (end < text + size && *end != '\n' && *end != '\0')
+            end++;
+        *end = '\0';
+        if (end > token || end < text + size)
+            argv[argc++] = token;
+        token = end + 1;
+    }
+
+    // these answer and exit, or start profiling for the rest of the process
+    if (argc > 1 && (strcmp(argv[1], "--__complete") == 0 || strncmp(argv[1], MYARGS_PROFILE_FLAG, sizeof(MYARGS_PROFILE_FLAG) - 1) == 0))
+    {
+        free(text);
+        return 0;
+    }
+
+    ArgumentParser reference, zero_copy, lazy, frozen, flat, flat_frozen;
+    build_parser(&reference, true);
+    build_parser(&zero_copy, true);
+    build_parser(&lazy, true);
+    build_parser(&frozen, true);
+    build_parser(&flat, false);
+    build_parser(&flat_frozen, false);
+    zero_copy.zero_copy = true;
+    lazy.lazy = true;
+    ArgumentStatus full_status = parse_args_const(&reference, argc, argv);
+    check(parse_args_const(&zero_copy, argc, argv) == full_status, "zero-copy", &reference, -1);
+    parse_args_const(&lazy, argc, argv);
+    // parse_args also parses the subcommand, which the result engines leave to the caller
+    ArgumentStatus status = myargs_status(&reference.result);
+
+    const ArgumentParser *schema = freeze_parser(&frozen);
+    ArgumentResult into;
+    init_result(&into, schema, NULL, 0);
+    check(parse_args_into(schema, &into, argc, argv) == status, "parse_args_into", &reference, -1);
+
+    // snapshots cannot hold subcommands, so they are checked against a
+    // reference without one
+    ArgumentStatus flat_status = parse_args_const(&flat, argc, argv);
+    const ArgumentParser *flat_schema = freeze_parser(&flat_frozen);
+    size_t snapshot_size = save_schema(flat_schema, NULL, 0);
+    void *snapshot = malloc(snapshot_size);
+    save_schema(flat_schema, snapshot, snapshot_size);
+    ArgumentParser loaded;
+    check(load_schema(&loaded, snapshot, snapshot_size) == 0, "load_schema", &flat, -1);
+    ArgumentResult from_snapshot;
+    init_result(&from_snapshot, &loaded, NULL, 0);
+    check(parse_args_into(&loaded, &from_snapshot, argc, argv) == flat_status, "snapshot", &flat, -1);
+
+    size_t state_size = save_state(&flat, NULL, NULL, 0);
+    void *region = malloc(state_size);
+    save_state(&flat, NULL, region, state_size);
+    ArgumentParser state;
+    check(load_state(&state, region, state_size) == 0, "load_state", &flat, -1);
+
+    ArgumentResult streamed;
+    init_result(&streamed, schema, NULL, 0);
+    for (int i = 1; i < argc && streamed.command < 0; i++)
+        parser_feed_into(schema, &streamed, argv[i], strlen(argv[i]));
+    ArgumentStatus streamed_status = parser_finish_into(schema, &streamed);
+
+    const int argcs[2] = {argc, argc};
+    const char *const *argvs[2] = {argv, argv};
+    ArgumentBatch batch;
+    init_batch(&batch);
+    parse_args_batch(schema, 2, argcs, argvs, &batch);
+
+    for (ArgumentHandle handle = 0; handle < reference.count; handle++)
+    {
+        check(same_value(&reference.result, &zero_copy.result, handle), "zero-copy", &reference, handle);
+        check(same_value(&reference.result, &lazy.result, handle), "lazy", &reference, handle);
+        check(same_value(&reference.result, &into, handle), "parse_args_into", &reference, handle);
+        check(same_value(&flat.result, &from_snapshot, handle), "snapshot", &flat, handle);
+        check(same_value(&flat.result, &state.result, handle), "load_state", &flat, handle);
+        const char *expected = get_result_value(&reference.result, handle);
+        const char *row = batch.column[handle].values[1];
+        check((expected == NULL) == (row == NULL) && (!expected || strcmp(expected, row) == 0), "parse_args_batch", &reference, handle);
+        check(same_value(&reference.result, &streamed, handle), "parser_feed", &reference, handle);
+    }
+    check(streamed_status == status, "parser_feed", &reference, -1);
+    check(same_errors(&reference.result, &lazy.result), "lazy", &reference, -1);
+    format_help(&reference, 1, 1, 1, 1, NULL);
+
+    free_batch(&batch);
+    free_result(&streamed);
+    free_parser(&state);
+    free(region);
+    free_result(&from_snapshot);
+    free_parser(&loaded);
+    free(snapshot);
+    free_result(&into);
+    free_parser(&flat_frozen);
+    free_parser(&flat);
+    free_parser(&frozen);
+    free_parser(&lazy);
+    free_parser(&zero_copy);
+    free_parser(&reference);
+    free(text);
+    return 0;
+}
+
+#ifdef MYARGS_FUZZ_MAIN
+#include <time.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/**
+ * Replays one input for about a second and prints its exec/s and the peak
+ * RSS of the process that ran it.
+ */
+static void replay(const char *path)
+{
+    FILE *file = fopen(path, "rb");
+    if (!file)
+    {
+        fprintf(stderr, "Cannot open %s\n", path);
+        exit(EXIT_FAILURE);
+    }
+    uint8_t *data = NULL;
+    size_t size = 0, capacity = 0, n;
+    uint8_t chunk[4096];
+    while ((n = fread(chunk, 1, sizeof(chunk), file)) > 0)
+    {
+        if (size + n > capacity)
+        {
+            capacity = (size + n) * 2;
+            data = (uint8_t *)realloc(data, capacity);
+        }
+        memcpy(data + size, chunk, n);
+        size += n;
+    }
+    fclose(file);
+
+    struct timespec start, now;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    long runs = 0;
+    double elapsed;
+    do
+    {
+        LLVMFuzzerTestOneInput(data, size);
+        runs++;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        elapsed = (double)(now.tv_sec - start.tv_sec) + (double)(now.tv_nsec - start.tv_nsec) / 1e9;
+    } while (elapsed < 1.0);
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    printf("%-40s %10.0f exec/s %8ld KiB peak RSS\n", path, runs / elapsed, usage.ru_maxrss);
+    free(data);
+}
+
+int main(int argc, char *argv[])
+{
+    int failures = 0;
+    for (int i = 1; i < argc; i++)
+    {
+        fflush(stdout);
+        pid_t pid = fork();
+        if (pid == 0)
+        {
+            replay(argv[i]);
+            exit(EXIT_SUCCESS);
+        }
+        int status;
+        waitpid(pid, &status, 0);
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+        {
+            printf("%-40s failed\n", argv[i]);
+            failures++;
+        }
+    }
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+#endif // MYARGS_FUZZ_MAIN
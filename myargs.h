@@ -28,9 +28,7 @@
  * }
  */
 
-// TODO : nargs
 // TODO : arg parsing without - or --
-// TODO : Complete C++ Wrapper
 // TODO : Reimplement print_args
 // TODO : Documentation
 // TODO : Modify README
@@ -43,33 +41,149 @@
 #include <string.h> // for strdup strlen
 #include <stdarg.h>
 #include <stdbool.h>
+#include <errno.h>  // for strtoll strtod range errors
+#include <limits.h> // for INT_MAX
+#include <ctype.h>  // for isspace
+#include <stdint.h> // for uint32_t uintptr_t
+
+#if !defined(_WIN32) && !defined(MYARGS_NO_MMAP)
+#define MYARGS_MMAP
+#include <fcntl.h>    // for open
+#include <unistd.h>   // for close sysconf
+#include <sys/mman.h> // for mmap
+#include <sys/stat.h> // for fstat
+#endif // MYARGS_MMAP
+
+#ifdef _WIN32
+#include <io.h> // for _isatty
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif // WIN32_LEAN_AND_MEAN
+#include <windows.h> // for QueryPerformanceCounter
+#define environ _environ
+#else
+#include <unistd.h>    // for isatty
+#include <sys/ioctl.h> // for the terminal width
+extern char **environ;
+#endif // _WIN32
+
+#if !defined(MYARGS_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define MYARGS_SSE2
+#include <emmintrin.h> // for _mm_cmpeq_epi8 _mm_movemask_epi8
+#ifdef _MSC_VER
+#include <intrin.h> // for _BitScanForward64
+#endif // _MSC_VER
+#elif !defined(MYARGS_NO_SIMD) && (defined(__ARM_NEON) || defined(__ARM_NEON__)) && defined(__aarch64__)
+#define MYARGS_NEON
+#include <arm_neon.h> // for vceqq_u8 vshrn_n_u16
+#endif // MYARGS_NO_SIMD
+
+#if defined(MYARGS_SSE2) || defined(MYARGS_NEON)
+#if defined(__SANITIZE_ADDRESS__)
+#define MYARGS_NO_SANITIZE __attribute__((no_sanitize_address))
+#elif defined(__has_feature)
+#if __has_feature(address_sanitizer)
+#define MYARGS_NO_SANITIZE __attribute__((no_sanitize_address))
+#endif
+#endif
+#ifndef MYARGS_NO_SANITIZE
+#define MYARGS_NO_SANITIZE
+#endif
+#endif // MYARGS_SSE2 || MYARGS_NEON
 
 #ifdef __cplusplus
 #include <iostream>
 #include <exception>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <cerrno>
+#include <climits>
+#if __cplusplus >= 201703L || (defined(_MSVC_LANG) && _MSVC_LANG >= 201703L)
+#define MYARGS_CXX17
+#include <optional>
+#include <string_view>
+#endif // C++17
 #endif //__cplusplus
 
 #define MYARGS_VERSION_MAJOR 0
 #define MYARGS_VERSION_MINOR 1
 #define MYARGS_VERSION_PATCH 0
 
-#ifdef MYARGS_DEBUG
-#endif // MYARGS_DEBUG
-#define MYARGS_THEME_HELP
-#ifdef MYARGS_THEME_HELP
-#define ST "\e[0;32m" // symbol
-#define NT "\e[0;30m" // name
-#define RT "\e[0;33m" // required
-#define DT "\e[0;33m" // default
-#define FT "\e[0;30m" // allowed
-#define FT "\e[0;30m" // implicit
-#define CC "\e[0;34m" // colon
-#define NC "\e[0;30m" // none
-#define HT "\e[0;30m" //
+#ifndef MYARGS_ARENA_BLOCK_SIZE
+#define MYARGS_ARENA_BLOCK_SIZE 4096 // default size of a heap arena block
+#endif // MYARGS_ARENA_BLOCK_SIZE
+#define MYARGS_ARENA_ALIGN 16
+
+#define MYARGS_SCHEMA_MAGIC 0x5341594du // "MYAS" in a little-endian snapshot
+#define MYARGS_SCHEMA_VERSION 1
+#define MYARGS_STATE_MAGIC 0x5453594du // "MYST" in a little-endian state region
+#define MYARGS_STATE_VERSION 1
+
+#ifndef MYARGS_RESPONSE_DEPTH
+#define MYARGS_RESPONSE_DEPTH 16 // how deeply response files may include each other
+#endif // MYARGS_RESPONSE_DEPTH
+
+#ifndef MYARGS_MAX_ERRORS
+#define MYARGS_MAX_ERRORS 8 // errors a result keeps from one parse; later ones are only counted
+#endif // MYARGS_MAX_ERRORS
+#ifndef MYARGS_ERROR_TEXT
+#define MYARGS_ERROR_TEXT 1024 // bytes a result keeps for the text of its errors
+#endif // MYARGS_ERROR_TEXT
+
+#define NARGS_OPTIONAL (-1)     // nargs '?': zero or one value
+#define NARGS_ZERO_OR_MORE (-2) // nargs '*': any number of values
+#define NARGS_ONE_OR_MORE (-3)  // nargs '+': at least one value
+
+#define MYARGS_KIND_MULTI 0x80 // set in a frozen parser's kinds for an argument that takes several values
+
+#define MYARGS_COLOR_AUTO (-1)  // theme help only when stdout is a terminal and NO_COLOR is unset
+#define MYARGS_COLOR_NEVER 0    // plain help text
+#define MYARGS_COLOR_ALWAYS 1   // always theme help text
+
+#include <time.h> // for clock_gettime, or timespec_get where it is missing
+
+// myargs_stats is always kept by a MYARGS_DEBUG build, and by a MYARGS_PROFILE
+// build while profile mode is on; other builds compile the counting out
+#if defined(MYARGS_DEBUG) || defined(MYARGS_PROFILE)
+#define MYARGS_PROFILING // profile mode is compiled in
+#endif
+#if defined(MYARGS_DEBUG)
+#define MYARGS_COUNTING true
+#elif defined(MYARGS_PROFILE)
+#define MYARGS_COUNTING (myargs_profiler.out != NULL)
+#else
+#define MYARGS_COUNTING false
+#endif
+#define MYARGS_COUNT(counter, n) (MYARGS_COUNTING ? (void)(myargs_stats.counter += (n)) : (void)0)
+
+#define MYARGS_PROFILE_FLAG "--myargs-profile" // as the first argument, starts profiling before parse_args
+#ifndef MYARGS_PROFILE_LINE
+#define MYARGS_PROFILE_LINE 512 // bytes of one profile line; longer program names are cut short
+#endif // MYARGS_PROFILE_LINE
+
+// every thread keeps its own myargs_stats, so counting never races
+#if defined(__cplusplus) && __cplusplus >= 201103L
+#define MYARGS_THREAD_LOCAL thread_local
+#elif defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L && !defined(__STDC_NO_THREADS__)
+#define MYARGS_THREAD_LOCAL _Thread_local
+#elif defined(_MSC_VER)
+#define MYARGS_THREAD_LOCAL __declspec(thread)
+#elif defined(__GNUC__)
+#define MYARGS_THREAD_LOCAL __thread
 #else
-#define TNAME(x)
-#define TIMEIT()
-#endif // MYARGS_THEME_HELP
+#define MYARGS_THREAD_LOCAL // no thread-local storage: count on one thread only
+#endif
+
+// help theme, applied when the parser's color setting enables it
+#define ST "\033[0;32m" // symbol
+#define NT "\033[1m"    // name
+#define RT "\033[0;31m" // required
+#define DT "\033[0;33m" // default
+#define FT "\033[0;36m" // allowed
+#define CC "\033[0;34m" // colon
+#define NC "\033[0m"    // none
+#define HT "\033[0m"    // help
 
 #pragma region STRUCTURES
 
@@ -83,17 +197,73 @@ typedef enum Type
     ARG,   /**< A positional argument, which is required and has a value. */
 } Type;
 
+/**
+ * Represents the type an argument's value is converted to while parsing.
+ */
+typedef enum ValueType
+{
+    VALUE_STRING, /**< The value is kept as a string only. */
+    VALUE_INT,    /**< A 64-bit integer, in decimal, hex (0x) or octal (0). */
+    VALUE_DOUBLE, /**< A floating point number. */
+    VALUE_BOOL,   /**< true/false, yes/no, on/off or 1/0. */
+    VALUE_ENUM,   /**< One of the argument's choices, stored as its index. */
+    VALUE_SIZE,   /**< A byte count with an optional K, M, G or T suffix (powers of 1024). */
+} ValueType;
+
+/**
+ * The outcome of a parse. Every error a command line can contain has its own
+ * status; running out of memory still exits.
+ */
+typedef enum ArgumentStatus
+{
+    ARGUMENT_OK,            /**< The command line was parsed. */
+    ARGUMENT_UNKNOWN,       /**< A long option that is not registered. */
+    ARGUMENT_AMBIGUOUS,     /**< An abbreviation that more than one long option starts with. */
+    ARGUMENT_MISSING,       /**< A required argument that was not given. */
+    ARGUMENT_TOO_FEW,       /**< A multi-value argument given fewer values than it needs. */
+    ARGUMENT_INVALID,       /**< A value that cannot be converted to its argument's value_type. */
+    ARGUMENT_RESPONSE_FILE, /**< A response file that cannot be read or is nested too deeply. */
+    ARGUMENT_ERROR,         /**< Memory the parse needed could not be allocated. */
+} ArgumentStatus;
+
+/**
+ * One error found while parsing.
+ */
 typedef struct ArgumentError_t
 {
-    const char *argument;
-    const char *message;
+    const char *argument;  /**< The argument or option the error is about. */
+    const char *message;   /**< The message, as it is printed when exit_on_error is set. */
+    ArgumentStatus status; /**< What went wrong. */
+    int row;               /**< The row of parse_args_batch the error was found in, or -1 outside a batch. */
 } ArgumentError_t;
 
+/**
+ * The errors of the last parse into a result. It is part of the result, so
+ * recording an error never allocates; the strings of the errors are copied
+ * into text, and truncated once it is full.
+ */
+typedef struct ArgumentDiagnostics
+{
+    ArgumentError_t errors[MYARGS_MAX_ERRORS]; /**< The errors, in the order they were found. */
+    int count;                                 /**< The number of entries in errors. */
+    int dropped;                               /**< The number of errors found once errors was full. */
+    size_t used;                               /**< The number of bytes of text in use. */
+    int row;                                   /**< The batch row being parsed, or -1 outside parse_args_batch. */
+    ArgumentStatus row_status;                 /**< The status of the first error of that row, even if it was dropped. */
+    char text[MYARGS_ERROR_TEXT];              /**< Backing store for the strings of errors. */
+} ArgumentDiagnostics;
+
 typedef struct ArgumentTypeError_t
 {
     ArgumentError_t *error;
 } ArgumentTypeError_t;
 
+/**
+ * A stable reference to a registered argument, returned by the add_* functions.
+ * It remains valid for the lifetime of the parser.
+ */
+typedef int ArgumentHandle;
+
 /**
  * Represents an argument in the argument parser.
  */
@@ -104,15 +274,227 @@ typedef struct
     int required;  /**< Whether the argument is required. */
     char *help;    /**< The help message for the argument. */
     Type type;     /**< The type of the argument (FLAG, KWARG, ARG). */
-    int count;     /**< The number of arguments expected. */
+    int count;     /**< The number of values expected, or one of the NARGS_* constants. */
     char *def_val; /**< The default value for the argument. */
+    unsigned int hash; /**< The hash of the name, used by the lookup index. */
+    ValueType value_type; /**< The type value is converted to by parse_args. */
+    char *choices;        /**< The comma-separated choices of a VALUE_ENUM argument. */
+    char *env_value;      /**< The value of the argument's environment variable, set by load_env. */
+    char *config_value;   /**< The value of the argument in the config file, set by load_config. */
+
+} Argument;
+
+/**
+ * The heap functions the parser allocates through.
+ */
+typedef struct ArgumentAllocator
+{
+    void *(*allocate)(size_t size);              /**< Allocates a block, like malloc. */
+    void *(*reallocate)(void *ptr, size_t size); /**< Resizes a block, like realloc. */
+    void (*release)(void *ptr);                  /**< Releases a block, like free. */
+} ArgumentAllocator;
+
+/**
+ * The phases of an invocation that ArgumentStats times separately.
+ */
+typedef enum ArgumentPhaseKind
+{
+    PHASE_INIT,     /**< parser, init_parser, load_schema and load_state. */
+    PHASE_REGISTER, /**< add_arg, add_kwarg, add_flag and add_command. */
+    PHASE_PARSE,    /**< parse_args, parse_args_into and parser_feed. */
+    PHASE_HELP,     /**< print_help and format_help. */
+} ArgumentPhaseKind;
+
+/**
+ * Counters collected when compiled with MYARGS_DEBUG, and when compiled with
+ * MYARGS_PROFILE while profile mode is on. Each thread has its own, so threads parsing a frozen
+ * parser count without synchronizing.
+ */
+typedef struct ArgumentStats
+{
+    size_t allocations;   /**< The number of heap allocations and reallocations. */
+    size_t frees;         /**< The number of heap blocks released. */
+    size_t bytes;         /**< The number of bytes requested from the heap. */
+    size_t lookups;       /**< The number of name and symbol lookups. */
+    double init_time;     /**< Seconds spent initializing parsers and loading snapshots. */
+    double register_time; /**< Seconds spent in add_arg, add_kwarg, add_flag and add_command. */
+    double parse_time;    /**< Seconds spent parsing command lines. */
+    double help_time;     /**< Seconds spent rendering help. */
+    double tokenize_time; /**< The part of parse_time spent reading and classifying tokens. */
+    double lookup_time;   /**< The part of parse_time spent matching tokens to arguments and storing their values. */
+    double defaults_time; /**< The part of parse_time spent checking required arguments and finishing values. */
+    size_t calls[4];      /**< The number of calls of each phase, indexed by ArgumentPhaseKind. */
+} ArgumentStats;
+
+/**
+ * The state of profile mode, started by myargs_start_profile, the
+ * MYARGS_PROFILE environment variable or MYARGS_PROFILE_FLAG. Start it before
+ * starting threads; after that it is only read. Its lines are built from the
+ * ArgumentStats of the thread that writes them.
+ */
+typedef struct ArgumentProfile
+{
+    FILE *out;     /**< Receives one JSON line per phase, or NULL while profiling is off. */
+    bool checked;  /**< Whether MYARGS_PROFILE has been read. */
+    bool reported; /**< Whether the exit handler that writes the totals is registered. */
+} ArgumentProfile;
+
+/**
+ * Where a phase started: the clock and the counters, so its time and the
+ * profile line written at its end come from the differences.
+ */
+typedef struct ArgumentPhase
+{
+    unsigned long long start; /**< The clock, in nanoseconds, or 0 while nothing is counted. */
+    ArgumentStats stats;      /**< myargs_stats at the start. */
+} ArgumentPhase;
+
+/**
+ * A growable string that help text is formatted into before being written
+ * out in one go.
+ */
+typedef struct ArgumentBuffer
+{
+    char *data;      /**< The text, NUL terminated. */
+    size_t length;   /**< The length of the text. */
+    size_t capacity; /**< The number of bytes allocated for data. */
+} ArgumentBuffer;
+
+/**
+ * The kind of a command-line token.
+ */
+typedef enum
+{
+    TOKEN_LONG,       /**< --name or --name=value */
+    TOKEN_SHORT,      /**< -s, a bundle such as -abc, or either with =value */
+    TOKEN_BARE,       /**< name=value or a positional token */
+    TOKEN_TERMINATOR, /**< -- on its own */
+} TokenClass;
+
+/**
+ * A token split into its name and value by a single scan.
+ */
+typedef struct ArgumentToken
+{
+    TokenClass kind;     /**< The kind of token. */
+    const char *name;    /**< The name, after any leading dashes. */
+    size_t length;       /**< The length of name, up to the '=' if any. */
+    const char *value;   /**< The text after the '=', or NULL if there is none. */
+    size_t value_length; /**< The length of value. */
+} ArgumentToken;
+
+/**
+ * The parsed state of one argument.
+ */
+typedef struct ArgumentValue
+{
+    char *value;   /**< The value of the argument (the first one if multiple). */
+    char **values; /**< The values of the argument if multiple, a span of the result's value pool. */
+    int nvalues;   /**< The number of entries in values. */
+    size_t length; /**< The length of value, in bytes. */
+    bool pending;  /**< Whether a lazy parse left the default, copy and conversion to the first read. */
     union
     {
-        char *value;   /**< The value of the argument. */
-        char **values; /**< The values of the argument if multiple. */
+        long long integer; /**< The converted value of a VALUE_INT, VALUE_BOOL, VALUE_ENUM or VALUE_SIZE argument. */
+        double real;       /**< The converted value of a VALUE_DOUBLE argument. */
     };
+} ArgumentValue;
 
-} Argument;
+/**
+ * A block of memory that parser-owned strings and tables are bump-allocated
+ * from. The usable bytes follow the header; full blocks are chained so they can
+ * all be released at once.
+ */
+typedef struct ArgumentArena
+{
+    struct ArgumentArena *next; /**< The previously filled block, if any. */
+    size_t size;                /**< The number of usable bytes in the block. */
+    size_t used;                /**< The number of bytes already handed out. */
+    bool owned;                 /**< Whether the parser allocated the block (false for a caller buffer). */
+} ArgumentArena;
+
+/**
+ * A response file read during a parse. Tokens and values point into data, so
+ * it is only released when the result is reset or freed.
+ */
+typedef struct ArgumentFile
+{
+    struct ArgumentFile *next; /**< The previously opened file, if any. */
+    char *data;                /**< The contents of the file. */
+    size_t size;               /**< The size of data in bytes. */
+    bool mapped;               /**< Whether data is a memory mapping rather than a heap copy. */
+} ArgumentFile;
+
+/**
+ * The unread part of a response file being tokenized.
+ */
+typedef struct ArgumentFrame
+{
+    ArgumentFile *file; /**< The file being tokenized. */
+    char *pos;          /**< The next byte to tokenize. */
+    char *end;          /**< The end of the file. */
+    bool terminated;    /**< Whether the byte at end can act as the last token's terminator. */
+} ArgumentFrame;
+
+/**
+ * The outcome of parsing one command line against an ArgumentParser, kept
+ * apart from the parser so a registered schema can be reused for any number
+ * of parses. Everything a parse allocates comes from the result's arena,
+ * which reset_result rewinds without returning it to the heap.
+ */
+typedef struct ArgumentResult
+{
+    ArgumentValue *values; /**< The parsed state of each argument, indexed by handle. */
+    int capacity;          /**< The number of entries allocated in values. */
+    bool owns_values;      /**< Whether values was allocated by init_result and is freed with the result. */
+    ArgumentArena *arena;  /**< Per-parse memory: copied values, the value pool and response file records. */
+    char **value_pool;     /**< Backing store for the values of every multi-value argument. */
+    int value_pool_size;   /**< The number of entries allocated in value_pool. */
+    int value_pool_used;   /**< The number of entries of value_pool filled since it was allocated. */
+    ArgumentFile *files;   /**< The response files read by the current parse. */
+    const struct ArgumentParser *parser; /**< The parser that last filled the result. */
+    int command;           /**< The subcommand named by the command line, or -1. */
+    int command_offset;    /**< The argv index of the subcommand's name. */
+    bool streaming;        /**< Whether parser_feed has begun a command line that is not yet finished. */
+    int open_argument;     /**< A multi-value argument still taking values from fed tokens, or -1. */
+    int open_start;        /**< The value pool index of open_argument's first value. */
+    ArgumentDiagnostics diagnostics; /**< The errors of the current parse. */
+} ArgumentResult;
+
+/**
+ * Registers the arguments of a subcommand on its freshly initialized parser.
+ * It runs at most once per subcommand, the first time the subcommand is needed.
+ */
+typedef void (*ArgumentCommandBuilder)(struct ArgumentParser *parser, void *data);
+
+/**
+ * A subcommand, such as the "clone" of "git clone". Its parser is only built
+ * when its name appears on the command line.
+ */
+typedef struct ArgumentCommand
+{
+    char *name;                    /**< The name of the subcommand. */
+    char *help;                    /**< The help message for the subcommand. */
+    unsigned int hash;             /**< The hash of the name, used by the command index. */
+    ArgumentCommandBuilder build;  /**< Registers the subcommand's arguments. */
+    void *data;                    /**< Passed to build. */
+    struct ArgumentParser *parser; /**< The subcommand's parser, or NULL until it is built. */
+} ArgumentCommand;
+
+/**
+ * Walks the tokens of a command line, descending into response files as
+ * they are named so the expansion is streamed rather than materialized.
+ */
+typedef struct ArgumentCursor
+{
+    const char *const *argv;                    /**< The argument vector. */
+    int argc;                                   /**< The argument count. */
+    int index;                                  /**< The next argv entry to read. */
+    int depth;                                  /**< The number of open response files. */
+    ArgumentFrame frames[MYARGS_RESPONSE_DEPTH]; /**< The open response files, innermost last. */
+    const char *peeked;                         /**< A token read ahead, or NULL. */
+    bool stream;                                /**< Whether more tokens may be fed once argv runs out. */
+} ArgumentCursor;
 
 /**
  * Represents the argument parser.
@@ -123,19 +505,207 @@ typedef struct ArgumentParser
     char *usage;         /**< The usage message. */
     char *epilog;        /**< The epilog message. */
     int count;           /**< The number of arguments. */
+    int capacity;        /**< The number of arguments allocated. */
     char *description;   /**< The description of the program. */
     Argument *arguments; /**< The list of arguments. */
     char prefix_char;
     const char *argument_default;
     bool add_help;
-    bool allow_abbrev;
-    bool exit_on_error;
+    bool allow_abbrev;   /**< Whether a long option may be given as any unambiguous prefix of its name. */
+    bool exit_on_error;  /**< Whether a parse error is printed and exits, rather than being recorded for get_errors. */
+    bool zero_copy;      /**< Whether parsed values point into argv instead of being copied. */
+    bool lazy;           /**< Whether parse_args defers defaults, copies and conversions until a value is first read. */
+    char fromfile_prefix_char; /**< The prefix marking a response file token, such as '@', or 0 for none. */
+    int *index;          /**< Open-addressed hash table of argument indices keyed by name (-1 is empty). */
+    int index_size;      /**< The number of slots in the index, always a power of two. */
+    int syms[256];       /**< Maps a short symbol to its argument index (-1 if unused). */
+    int *sorted;         /**< Argument indices in order of name, one per distinct name, for abbreviations and suggestions. */
+    int sorted_count;    /**< The number of entries in sorted. */
+    ArgumentArena *arena; /**< The current arena block, or NULL when using the heap. */
+    ArgumentResult result; /**< The result filled in by parse_args and read by the get_* functions. */
+    bool frozen;           /**< Whether freeze_parser made the parser read-only. */
+    char *help_text;       /**< The help text rendered by format_help, or NULL until it is needed. */
+    size_t help_length;    /**< The length of help_text. */
+    int help_flags;        /**< The sections help_text was rendered with. */
+    size_t help_columns;   /**< The line width help_text was wrapped to. */
+    size_t help_column;    /**< The width of the option column, measured once by the layout pass. */
+    int color;             /**< MYARGS_COLOR_AUTO (the default), MYARGS_COLOR_NEVER or MYARGS_COLOR_ALWAYS. */
+    int help_width;        /**< The width help is wrapped to, or 0 to use the terminal's. */
+    ArgumentCommand *commands; /**< The subcommands, in registration order. */
+    int command_count;     /**< The number of subcommands. */
+    int command_capacity;  /**< The number of subcommands allocated. */
+    int *command_index;    /**< Open-addressed hash table of subcommand indices keyed by name (-1 is empty). */
+    int command_index_size; /**< The number of slots in command_index, always a power of two. */
+    const void *schema;    /**< The snapshot the parser was loaded from, whose strings it points into, or NULL. */
+    unsigned int *hashes;  /**< The hash of each argument's name, packed densely by freeze_parser for lookups, or NULL. */
+    uint32_t *name_offsets; /**< Where each argument's name starts in names, or NULL until frozen. */
+    uint8_t *kinds;        /**< The Type of each argument, with MYARGS_KIND_MULTI for multi-value arguments, or NULL until frozen. */
+    char *names;           /**< Every name once frozen, each after a length byte (255 if longer) and NUL terminated, in one pool. */
+    unsigned long long started; /**< The clock, in nanoseconds, when the parser was initialized, for profile mode. */
 } ArgumentParser;
 
+/**
+ * The values of one argument across every command line of a batch, one
+ * entry per row, so each column can be scanned on its own.
+ */
+typedef struct ArgumentColumn
+{
+    char **values;  /**< The value of the argument in each row (the first one if multiple), or NULL. */
+    char ***spans;  /**< The values of a multi-value argument in each row, or NULL for other arguments. */
+    int *nvalues;   /**< The number of values in each row, or NULL for single-value arguments. */
+    union
+    {
+        long long *integers; /**< The converted values of an integer-typed argument, or NULL for VALUE_STRING. */
+        double *reals;       /**< The converted values of a VALUE_DOUBLE argument. */
+    };
+} ArgumentColumn;
+
+/**
+ * The results of parse_args_batch, laid out as one column per argument.
+ * Strings and columns live in the scratch result's arena, which the next
+ * batch reuses.
+ */
+typedef struct ArgumentBatch
+{
+    int rows;               /**< The number of command lines parsed. */
+    int columns;            /**< The number of arguments, one column each. */
+    ArgumentColumn *column; /**< The columns, indexed by handle. */
+    ArgumentStatus *status; /**< The status of each row: that of its first error, or ARGUMENT_OK. */
+    ArgumentResult scratch; /**< The per-row result the columns are filled from. */
+} ArgumentBatch;
+
+/**
+ * The header of a schema snapshot written by save_schema. Strings are stored
+ * as offsets from the start of the snapshot (0 for NULL) so it can be loaded
+ * wherever it is mapped. The header is followed by count ArgumentSchemaEntry
+ * records, the name index, the sorted name list and the strings.
+ */
+typedef struct ArgumentSchema
+{
+    uint32_t magic;        /**< MYARGS_SCHEMA_MAGIC, which also rejects a snapshot of the other byte order. */
+    uint32_t version;      /**< MYARGS_SCHEMA_VERSION. */
+    uint32_t size;         /**< The size of the snapshot in bytes. */
+    int32_t count;         /**< The number of arguments. */
+    int32_t index_size;    /**< The number of slots in the name index. */
+    int32_t sorted_count;  /**< The number of entries in the sorted name list. */
+    int32_t syms[256];     /**< The symbol table. */
+    uint32_t program;      /**< The offset of the program name. */
+    uint32_t usage;        /**< The offset of the usage message. */
+    uint32_t description;  /**< The offset of the description. */
+    uint32_t epilog;       /**< The offset of the epilog. */
+    uint32_t help_column;  /**< The width of the option column of the help layout. */
+    uint32_t help_columns; /**< The line width the layout was measured for. */
+    char prefix_char;
+    char fromfile_prefix_char;
+    uint8_t add_help;
+    uint8_t allow_abbrev;
+    uint8_t exit_on_error;
+    uint8_t zero_copy;
+    uint8_t lazy;
+    uint8_t reserved;
+} ArgumentSchema;
+
+/**
+ * An argument in a schema snapshot.
+ */
+typedef struct ArgumentSchemaEntry
+{
+    uint32_t name;     /**< The offset of the name. */
+    uint32_t help;     /**< The offset of the help message. */
+    uint32_t def_val;  /**< The offset of the default value. */
+    uint32_t choices;  /**< The offset of the choices. */
+    uint32_t hash;     /**< The hash of the name. */
+    int32_t required;  /**< Whether the argument is required. */
+    int32_t count;     /**< The number of values expected. */
+    char sym;          /**< The short symbol. */
+    uint8_t type;      /**< The Type of the argument. */
+    uint8_t value_type; /**< The ValueType of the argument. */
+    uint8_t reserved;
+} ArgumentSchemaEntry;
+
+/**
+ * The header of a parsed state written by save_state. The region starts with
+ * a schema snapshot; this header follows it at the next multiple of 8, then
+ * count ArgumentStateEntry records, the value list and the strings. Like the
+ * snapshot it holds offsets from the start of the region, never pointers.
+ */
+typedef struct ArgumentState
+{
+    uint32_t magic;       /**< MYARGS_STATE_MAGIC. */
+    uint32_t version;     /**< MYARGS_STATE_VERSION. */
+    uint32_t size;        /**< The size of the whole region in bytes. */
+    uint32_t schema_size; /**< The size of the schema snapshot the region starts with. */
+    int32_t count;        /**< The number of arguments. */
+    int32_t value_count;  /**< The number of entries in the value list. */
+} ArgumentState;
+
+/**
+ * The parsed value of an argument in a state region.
+ */
+typedef struct ArgumentStateEntry
+{
+    uint32_t value;   /**< The offset of the value, or 0 if there is none. */
+    uint32_t length;  /**< The length of the value. */
+    uint32_t values;  /**< The index of the argument's first entry in the value list. */
+    int32_t nvalues;  /**< The number of the argument's entries in the value list. */
+    int64_t integer;  /**< The converted value; the bits of the double for a VALUE_DOUBLE argument. */
+} ArgumentStateEntry;
+
 #pragma endregion // STRUCTURES
 
 #pragma region DECLARATIONS
 
+/**
+ * Replaces the heap functions every parser allocates through, for example to
+ * route its memory into a tracked pool. Call it before creating any parser,
+ * and keep the functions until the last parser is freed. A NULL function
+ * restores the C library's.
+ *
+ * @param malloc_fn Allocates a block.
+ * @param realloc_fn Resizes a block.
+ * @param free_fn Releases a block.
+ *
+ * Example usage:
+ * myargs_set_allocator(pool_malloc, pool_realloc, pool_free);
+ */
+void myargs_set_allocator(void *(*malloc_fn)(size_t), void *(*realloc_fn)(void *, size_t), void (*free_fn)(void *));
+
+/**
+ * Retrieves the counters the calling thread collected since it started or
+ * since its last myargs_reset_stats. MYARGS_PROFILE builds only count while
+ * profile mode is on, and other builds without MYARGS_DEBUG never do.
+ *
+ * @return The counters.
+ */
+const ArgumentStats *myargs_get_stats(void);
+
+/**
+ * Clears the counters of the calling thread.
+ */
+void myargs_reset_stats(void);
+
+/**
+ * Starts profile mode, which is only compiled in when MYARGS_PROFILE or
+ * MYARGS_DEBUG is defined. From then on every init, add_*, parse and
+ * print_help writes one JSON line with its duration in nanoseconds and the
+ * heap allocations and bytes it made, and the totals per phase are written
+ * at exit, from the counters of the thread that exits. Parses also split
+ * their time into tokenize, lookup and defaults. Setting the MYARGS_PROFILE
+ * environment variable before the first parser is initialized, or passing
+ * MYARGS_PROFILE_FLAG (optionally as --myargs-profile=FILE) as the first
+ * argument, starts it the same way.
+ *
+ * @param path The file the lines are appended to, or NULL, "", "-" or "1"
+ * for stderr.
+ * @return 0 on success, or -1 if the file cannot be opened or profile mode
+ * is not compiled in.
+ *
+ * Example usage:
+ * myargs_start_profile("/var/log/startup.jsonl");
+ * // {"phase":"add_kwarg","program":"tool","name":"count","ns":412,"allocations":0,"bytes":0}
+ */
+int myargs_start_profile(const char *path);
+
 /**
  * Prints the help message.
  *
@@ -148,6 +718,9 @@ typedef struct ArgumentParser
  * @param h add_help
  * @param a allow_abbrev
  * @param r exit_on_error
+ * @param z zero_copy
+ * @param l lazy
+ * @param f fromfile_prefix_char
  * @param D argument_default
  *
  * Example usage:
@@ -171,6 +744,26 @@ void parser(ArgumentParser *parser, const char *format, ...);
  */
 void init_parser(ArgumentParser *parser, const char *program, const char *usage, const char *description, const char *epilog);
 
+/**
+ * Initializes an ArgumentParser instance whose strings, argument records and
+ * parsed values are all bump-allocated from an arena, so free_parser releases
+ * them in one go instead of one free per string.
+ *
+ * @param parser The ArgumentParser to initialize.
+ * @param buffer A caller-owned buffer to allocate from first, or NULL to start with a heap block.
+ * @param size The size of buffer, or the initial heap block size when buffer is NULL. 0 disables the arena.
+ * @param program The name of the program.
+ * @param usage The usage message.
+ * @param description The description of the program.
+ * @param epilog The epilog message.
+ *
+ * Example usage:
+ * static char memory[8192];
+ * ArgumentParser parser;
+ * init_parser_arena(&parser, memory, sizeof(memory), "my_program", "Usage: my_program [options]", "This is a sample program.", "Epilog message");
+ */
+void init_parser_arena(ArgumentParser *parser, void *buffer, size_t size, const char *program, const char *usage, const char *description, const char *epilog);
+
 /**
  * Adds an argument to the argument parser.
  *
@@ -178,14 +771,15 @@ void init_parser(ArgumentParser *parser, const char *program, const char *usage,
  * @param sym The short symbol for the argument.
  * @param name The long name for the argument.
  * @param required Whether the argument is required.
- * @param nargs The number of arguments expected.
+ * @param nargs The number of values expected: a count, NARGS_OPTIONAL, NARGS_ZERO_OR_MORE or NARGS_ONE_OR_MORE.
  * @param default_value The default value for the argument.
  * @param help The help message for the argument.
+ * @return A handle to the argument.
  *
  * Example usage:
  * add_arg(parser, 'o', "output", 1, 1, "default_output.txt", "Output file");
  */
-void add_arg(ArgumentParser *parser, char sym, const char *name, int required, int nargs, const char *default_value, const char *help);
+ArgumentHandle add_arg(ArgumentParser *parser, char sym, const char *name, int required, int nargs, const char *default_value, const char *help);
 
 /**
  * Adds a keyword argument to the argument parser.
@@ -196,11 +790,12 @@ void add_arg(ArgumentParser *parser, char sym, const char *name, int required, i
  * @param required Whether the argument is required.
  * @param default_value The default value for the argument.
  * @param help The help message for the argument.
+ * @return A handle to the argument.
  *
  * Example usage:
  * add_kwarg(parser, 'v', "verbose", 0, "false", "Enable verbose mode");
  */
-void add_kwarg(ArgumentParser *parser, char sym, const char *name, int required, const char *default_value, const char *help);
+ArgumentHandle add_kwarg(ArgumentParser *parser, char sym, const char *name, int required, const char *default_value, const char *help);
 
 /**
  * Adds a flag argument to the argument parser.
@@ -209,632 +804,5401 @@ void add_kwarg(ArgumentParser *parser, char sym, const char *name, int required,
  * @param sym The short symbol for the argument.
  * @param name The long name for the argument.
  * @param help The help message for the argument.
+ * @return A handle to the argument.
  *
  * Example usage:
  * add_flag(parser, 'h', "help", "Show help message");
  */
-void add_flag(ArgumentParser *parser, char sym, const char *name, const char *help);
+ArgumentHandle add_flag(ArgumentParser *parser, char sym, const char *name, const char *help);
 
 /**
- * Parses the command-line arguments.
+ * Adds a subcommand. Its parser is not created here: build runs the first
+ * time the subcommand's name is the first positional token of a command
+ * line, so only the subcommand that is used pays for its registration. The
+ * tokens after the name are parsed by the subcommand's parser, which starts
+ * with the parent's zero_copy, lazy, fromfile_prefix_char and help settings.
  *
- * @param parser The ArgumentParser instance.
- * @param argc The argument count.
- * @param argv The argument vector.
+ * @param parser The ArgumentParser to add the subcommand to.
+ * @param name The name of the subcommand.
+ * @param help The help message for the subcommand.
+ * @param build Registers the subcommand's arguments on its parser.
+ * @param data Passed to build.
+ * @return The index of the subcommand.
  *
  * Example usage:
- * parse_args(parser, argc, argv);
+ * static void build_clone(ArgumentParser *clone, void *data) {
+ *     add_flag(clone, 'b', "bare", "Make a bare repository");
+ * }
+ * int clone = add_command(parser, "clone", "Clone a repository", build_clone, NULL);
  */
-void parse_args(ArgumentParser *parser, int argc, char *argv[]);
+int add_command(ArgumentParser *parser, const char *name, const char *help, ArgumentCommandBuilder build, void *data);
 
 /**
- * Retrieves the value of an argument.
+ * Retrieves the subcommand named by the last parse_args.
  *
  * @param parser The ArgumentParser instance.
- * @param name The name of the argument.
- * @return The value of the argument.
+ * @return The index returned by add_command, or -1 if no subcommand was named.
  *
  * Example usage:
- * const char *output = get_arg(parser, "output");
+ * if (get_command(parser) == clone)
+ *     bare = get_flag(get_command_parser(parser, clone), "bare");
  */
-const char *get_arg(ArgumentParser *parser, const char *name);
+int get_command(const ArgumentParser *parser);
 
 /**
- * Retrieves the value of a keyword argument.
+ * Retrieves the parser of a subcommand, building it first if needed. On a
+ * frozen parser every subcommand was already built by freeze_parser, so this
+ * only reads it.
  *
  * @param parser The ArgumentParser instance.
- * @param name The name of the keyword argument.
- * @return The value of the keyword argument.
+ * @param command The index returned by add_command.
+ * @return The subcommand's parser, owned by parser.
+ */
+ArgumentParser *get_command_parser(ArgumentParser *parser, int command);
+
+/**
+ * Retrieves the subcommand named by the command line a result was parsed
+ * from. parse_args_into stops at the subcommand's name; the rest of the
+ * command line is left for the subcommand's parser.
+ *
+ * @param result The ArgumentResult instance.
+ * @param offset Receives the argv index of the subcommand's name, or NULL.
+ * @return The index returned by add_command, or -1 if no subcommand was named.
  *
  * Example usage:
- * const char *verbose = get_kwarg(parser, "verbose");
+ * int offset, command = get_result_command(&result, &offset);
+ * if (command >= 0)
+ *     parse_args_into(get_command_parser(parser, command), &sub, argc - offset, argv + offset);
  */
-const char *get_kwarg(ArgumentParser *parser, const char *name);
+int get_result_command(const ArgumentResult *result, int *offset);
 
 /**
- * Retrieves the value of a flag argument.
+ * Parses the command-line arguments. When fromfile_prefix_char is set, a
+ * token such as @args.txt is replaced by the whitespace-separated tokens of
+ * that file (quotes and backslashes are honoured, and nesting is allowed).
+ * A long option may be shortened to any prefix that only one name starts
+ * with, unless allow_abbrev is cleared. An unknown or ambiguous long option
+ * is an error that names the candidates or the closest registered name.
+ *
+ * An error is printed and ends the process while exit_on_error is set, as it
+ * is by default. With exit_on_error cleared, every error is recorded for
+ * get_errors instead, without allocating, and parsing goes on with the next
+ * token; the status tells whether there were any.
  *
  * @param parser The ArgumentParser instance.
- * @param name The name of the flag argument.
- * @return The value of the flag argument.
+ * @param argc The argument count.
+ * @param argv The argument vector.
+ * @return ARGUMENT_OK, or the status of the first error.
  *
  * Example usage:
- * int help = get_flag(parser, "help");
+ * if (parse_args(parser, argc, argv) != ARGUMENT_OK)
+ *     reply_with_errors(parser);
  */
-int get_flag(ArgumentParser *parser, const char *name);
+ArgumentStatus parse_args(ArgumentParser *parser, int argc, char *argv[]);
 
 /**
- * Prints the help message.
+ * Parses a command line that must not be modified, such as a frozen or shared
+ * argv. parse_args is a thin wrapper around this; neither writes to argv. With
+ * zero_copy set, every value is a view into its argv token, so argv must
+ * outlive the parser's use of the values. Arguments not given keep the value
+ * of an earlier parse; call reset_parser_values first to parse from scratch
+ * and reuse the memory of the previous values.
+ *
+ * With lazy set, parsing only records where each value is: the required
+ * check still runs, but defaults, copies and conversions happen when a value
+ * is first read through a get_* function, and an invalid value is reported
+ * then. argv must stay valid until every value that is read has been read.
  *
  * @param parser The ArgumentParser instance.
- * @param description Whether to print the description.
- * @param usage Whether to print the usage.
- * @param epilog Whether to print the epilog.
- * @param group Whether
+ * @param argc The argument count.
+ * @param argv The argument vector.
  *
  * Example usage:
- * print_help(parser, 1, 1, 1, 0);
+ * static const char *const args[] = {"my_program", "--count=5"};
+ * parse_args_const(parser, 2, args);
  */
-void print_help(ArgumentParser *parser, int description, int usage, int epilog, int group);
+ArgumentStatus parse_args_const(ArgumentParser *parser, int argc, const char *const argv[]);
 
 /**
- * Prints the help message.
+ * Clears the values of the last parse so the parser can parse another
+ * command line from scratch. The memory the values used is kept and reused
+ * by the next parse.
  *
  * @param parser The ArgumentParser instance.
  *
  * Example usage:
- * print_flag_help(parser, 1, 1, 1, 0);
+ * reset_parser_values(parser);
+ * parse_args(parser, argc, argv);
  */
-void print_arg_help(ArgumentParser *parser, int i);
+void reset_parser_values(ArgumentParser *parser);
 
 /**
- * Prints the help message.
+ * Initializes a result that parse_args_into can fill from parser. A parser
+ * is only read while parsing into a result, so it can be set up once and
+ * shared by any number of results.
  *
- * @param parser The ArgumentParser instance.
+ * @param result The ArgumentResult to initialize.
+ * @param parser The ArgumentParser whose arguments the result holds.
+ * @param buffer A caller-owned buffer for the values and their strings, or NULL to use the heap.
+ * @param size The size of buffer.
  *
  * Example usage:
- * print_flag_help(parser, 1, 1, 1, 0);
+ * ArgumentResult result;
+ * init_result(&result, parser, NULL, 0);
  */
-void print_flag_help(ArgumentParser *parser, int i);
+void init_result(ArgumentResult *result, const ArgumentParser *parser, void *buffer, size_t size);
 
 /**
- * Prints the help message.
+ * Parses a command line into result, discarding whatever it held before.
+ * Unlike parse_args this never modifies the parser.
  *
  * @param parser The ArgumentParser instance.
+ * @param result A result initialized for parser.
+ * @param argc The argument count.
+ * @param argv The argument vector.
+ * @return ARGUMENT_OK, or the status of the first error, recorded in result.
  *
  * Example usage:
- * print_flag_help(parser, 1, 1, 1, 0);
+ * parse_args_into(parser, &result, argc, (const char *const *)argv);
  */
-void print_kwarg_help(ArgumentParser *parser, int i);
+ArgumentStatus parse_args_into(const ArgumentParser *parser, ArgumentResult *result, int argc, const char *const argv[]);
 
 /**
- * Frees the memory allocated for the ArgumentParser instance.
+ * Parses a command line one token at a time, as the tokens arrive from stdin,
+ * a socket or another stage, without the whole argv ever being built. Each
+ * token is applied as soon as it is fed, through the same dispatch as
+ * parse_args, so the options fed so far can already be read with the get_*
+ * functions; a multi-value option keeps taking the tokens that follow it.
+ * The token does not need to be NUL-terminated and is copied, so its buffer
+ * can be reused at once. Unlike parse_args, the first token is not skipped
+ * as the program name. Once a subcommand is named, the rest of the tokens
+ * are fed to the subcommand's parser. Call parser_finish after the last token.
  *
  * @param parser The ArgumentParser instance.
+ * @param token The token.
+ * @param length The length of token in bytes.
+ * @return ARGUMENT_OK, or the status of the first error fed so far.
  *
  * Example usage:
- * free_parser(parser);
+ * while ((length = getline(&line, &capacity, stdin)) > 0)
+ *     parser_feed(parser, line, line[length - 1] == '\n' ? length - 1 : length);
+ * parser_finish(parser);
  */
-void free_parser(ArgumentParser *parser);
-
-#pragma endregion // DECLARATIONS
-
-#pragma region DEFINATIONS
+ArgumentStatus parser_feed(ArgumentParser *parser, const char *token, size_t length);
 
-void parser(ArgumentParser *parser, const char *format, ...)
-{
+/**
+ * Ends a command line fed with parser_feed: checks that the last option got
+ * enough values and that every required argument was given, then finishes
+ * the values as parse_args would. The next parser_feed starts a new command
+ * line.
+ *
+ * @param parser The ArgumentParser instance.
+ * @return ARGUMENT_OK, or the status of the first error of the command line.
+ */
+ArgumentStatus parser_finish(ArgumentParser *parser);
 
-    parser->program = NULL;
-    parser->usage = NULL;
-    parser->description = NULL;
-    parser->epilog = NULL;
-    parser->arguments = NULL;
-    parser->count = 0;
-    parser->prefix_char = '-';
-    parser->add_help = true;
-    parser->allow_abbrev = true;
-    parser->exit_on_error = true;
+/**
+ * Feeds one token of a command line being parsed into result, as parser_feed
+ * does for the parser's own result. The first token after init_result or
+ * parser_finish_into discards whatever result held before. The parser is only
+ * read. Once a subcommand is named the remaining tokens are ignored; feed
+ * them to the subcommand's parser with a result of its own.
+ *
+ * @param parser The ArgumentParser instance.
+ * @param result A result initialized for parser.
+ * @param token The token.
+ * @param length The length of token in bytes.
+ * @return ARGUMENT_OK, or the status of the first error fed so far.
+ */
+ArgumentStatus parser_feed_into(const ArgumentParser *parser, ArgumentResult *result, const char *token, size_t length);
 
-    if (format != NULL)
-    {
-        // Initialize variadic argument list
-        va_list args;
+/**
+ * Ends a command line fed with parser_feed_into.
+ *
+ * @param parser The ArgumentParser instance.
+ * @param result The result the tokens were fed into.
+ * @return ARGUMENT_OK, or the status of the first error of the command line.
+ */
+ArgumentStatus parser_finish_into(const ArgumentParser *parser, ArgumentResult *result);
 
-        va_start(args, format);
+/**
+ * Retrieves the errors of the last parse, when exit_on_error is cleared. The
+ * errors and their strings live in the parser's result, so they stay valid
+ * until the next parse. At most MYARGS_MAX_ERRORS are kept.
+ *
+ * @param parser The ArgumentParser instance.
+ * @param count Receives the number of errors.
+ * @return The errors, in the order they were found.
+ *
+ * Example usage:
+ * int count;
+ * const ArgumentError_t *errors = get_errors(parser, &count);
+ * for (int i = 0; i < count; i++)
+ *     fprintf(stderr, "%s\n", errors[i].message);
+ */
+const ArgumentError_t *get_errors(const ArgumentParser *parser, int *count);
 
-        size_t format_lenght = strlen(format);
-        char cc;
+/**
+ * Retrieves the errors of the last parse into a result, as get_errors does
+ * for a parser's own result.
+ *
+ * @param result The ArgumentResult instance.
+ * @param count Receives the number of errors.
+ * @return The errors, in the order they were found.
+ */
+const ArgumentError_t *get_result_errors(const ArgumentResult *result, int *count);
 
-        for (size_t i = 0; i < format_lenght; i++)
+/**
+ * Makes a parser read-only so it can be shared between threads. After this,
+ * add_*, set_type, set_choices and parse_args fail, and the parser is only
+ * read by parse_args_into and the get_result_* functions.
+ * Freezing also packs the names, their hashes and each argument's kind into
+ * dense arrays and one interned name pool, which is what lookups read from
+ * then on.
+ *
+ * Thread safety: any number of threads may call parse_args_into on the same
+ * frozen parser at once, without locks, as long as each thread parses into
+ * its own ArgumentResult and nothing writes to the parser's fields (such as
+ * zero_copy or fromfile_prefix_char) until every such call has returned. A
+ * result must not be used by two threads at once. argv is never written to,
+ * so threads may also share an argv. free_parser must wait for all threads.
+ *
+ * @param parser The ArgumentParser instance.
+ * @return The parser, as a read-only schema.
+ *
+ * Example usage:
+ * const ArgumentParser *schema = freeze_parser(parser);
+ */
+const ArgumentParser *freeze_parser(ArgumentParser *parser);
+
+/**
+ * Writes a snapshot of a parser's schema: its arguments, symbol table, name
+ * index, sorted name list and help layout. The snapshot holds no pointers, so
+ * it can be written to a file and mapped back, or compiled into the program
+ * as a const array, and load_schema uses it in place. Subcommands and the
+ * fallbacks of load_env and load_config are not part of it, so a parser with
+ * subcommands cannot be saved.
+ *
+ * @param parser The ArgumentParser instance, typically frozen.
+ * @param buffer The buffer to write to, or NULL to only measure.
+ * @param size The size of buffer.
+ * @return The size of the snapshot, written only if it fits in size, or 0 if the parser cannot be saved.
+ *
+ * Example usage:
+ * size_t size = save_schema(parser, NULL, 0);
+ * void *snapshot = malloc(size);
+ * save_schema(parser, snapshot, size);
+ */
+size_t save_schema(const ArgumentParser *parser, void *buffer, size_t size);
+
+/**
+ * Initializes a frozen parser from a snapshot written by save_schema. Names,
+ * help and defaults are read in place from the snapshot, which must outlive
+ * the parser; the only allocation is one block for the argument records and
+ * tables. Parse with parse_args_into, as with any frozen parser.
+ *
+ * @param parser The ArgumentParser to initialize.
+ * @param snapshot The snapshot.
+ * @param size The size of snapshot.
+ * @return 0 on success, or -1 if snapshot is not a valid snapshot of this version.
+ *
+ * Example usage:
+ * ArgumentParser parser;
+ * if (load_schema(&parser, snapshot, sizeof(snapshot)) == 0)
+ *     parse_args_into(&parser, &result, argc, argv);
+ */
+int load_schema(ArgumentParser *parser, const void *snapshot, size_t size);
+
+/**
+ * Packs a parser's schema and the values of a parse into one contiguous
+ * region. The region holds offsets rather than pointers, so it can be placed
+ * in a MAP_SHARED mapping, written to a file, or filled before fork and left
+ * untouched so that it stays shared copy-on-write. Lazily kept values are
+ * finished first. As with save_schema, a parser with subcommands cannot be
+ * saved.
+ *
+ * @param parser The ArgumentParser instance, typically frozen.
+ * @param result The result holding the values, or NULL for the parser's own.
+ * @param buffer The buffer to write to, or NULL to only measure.
+ * @param size The size of buffer.
+ * @return The size of the region, written only if it fits in size, or 0 if the parser cannot be saved.
+ *
+ * Example usage:
+ * size_t size = save_state(parser, NULL, NULL, 0);
+ * void *region = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+ * save_state(parser, NULL, region, size);
+ */
+size_t save_state(const ArgumentParser *parser, const ArgumentResult *result, void *buffer, size_t size);
+
+/**
+ * Initializes a frozen parser whose values are those of a region written by
+ * save_state, so a worker can read them with the get_* functions without
+ * parsing. Names, defaults and values are all read in place from the region,
+ * which is never written to and must outlive the parser; the only allocation
+ * is the one block load_schema makes, plus the value list's pointers.
+ *
+ * @param parser The ArgumentParser to initialize.
+ * @param region The region.
+ * @param size The size of region.
+ * @return 0 on success, or -1 if region is not a valid state of this version.
+ *
+ * Example usage:
+ * // in each worker, after fork
+ * ArgumentParser shared;
+ * if (load_state(&shared, region, size) == 0)
+ *     long long count = get_int_h(&shared, count_handle);
+ */
+int load_state(ArgumentParser *parser, const void *region, size_t size);
+
+/**
+ * Clears the values held by a result, keeping its memory for the next parse.
+ *
+ * @param result The ArgumentResult instance.
+ */
+void reset_result(ArgumentResult *result);
+
+/**
+ * Frees the memory held by a result.
+ *
+ * @param result The ArgumentResult instance.
+ */
+void free_result(ArgumentResult *result);
+
+/**
+ * Initializes an empty batch for parse_args_batch.
+ *
+ * @param batch The ArgumentBatch to initialize.
+ */
+void init_batch(ArgumentBatch *batch);
+
+/**
+ * Parses many command lines against the same parser, storing the results by
+ * column: batch->column[handle].values[row] is the value of an argument in
+ * one command line. One scratch result is reused for every row and the
+ * memory of the previous batch is recycled, so a batch costs a handful of
+ * allocations however many rows it has. A bad row never ends the process,
+ * even with exit_on_error set: batch->status[row] holds the status of each
+ * row, and every error in batch->scratch records its row. Like
+ * parse_args_into this only reads the parser; to use several threads, give
+ * each a frozen parser's slice of the rows and a batch of its own.
+ *
+ * @param parser The ArgumentParser instance.
+ * @param n The number of command lines.
+ * @param argcs The argument count of each command line.
+ * @param argvs The argument vector of each command line.
+ * @param batch The batch receiving the results, discarding what it held before.
+ * @return ARGUMENT_OK, or the status of the first error recorded.
+ *
+ * Example usage:
+ * ArgumentBatch batch;
+ * init_batch(&batch);
+ * parse_args_batch(parser, n, argcs, argvs, &batch);
+ * long long *counts = batch.column[count].integers;
+ */
+ArgumentStatus parse_args_batch(const ArgumentParser *parser, int n, const int argcs[], const char *const *const argvs[], ArgumentBatch *batch);
+
+/**
+ * Frees the memory held by a batch.
+ *
+ * @param batch The ArgumentBatch instance.
+ */
+void free_batch(ArgumentBatch *batch);
+
+/**
+ * Retrieves the value of an argument.
+ *
+ * @param parser The ArgumentParser instance.
+ * @param name The name of the argument.
+ * @return The value of the argument.
+ *
+ * Example usage:
+ * const char *output = get_arg(parser, "output");
+ */
+const char *get_arg(ArgumentParser *parser, const char *name);
+
+/**
+ * Retrieves the value of a keyword argument.
+ *
+ * @param parser The ArgumentParser instance.
+ * @param name The name of the keyword argument.
+ * @return The value of the keyword argument.
+ *
+ * Example usage:
+ * const char *verbose = get_kwarg(parser, "verbose");
+ */
+const char *get_kwarg(ArgumentParser *parser, const char *name);
+
+/**
+ * Retrieves the value of a flag argument.
+ *
+ * @param parser The ArgumentParser instance.
+ * @param name The name of the flag argument.
+ * @return The value of the flag argument.
+ *
+ * Example usage:
+ * int help = get_flag(parser, "help");
+ */
+int get_flag(ArgumentParser *parser, const char *name);
+
+/**
+ * Retrieves the value of an argument through its handle, without a name lookup.
+ * Only valid after parse_args, which has already applied the default value.
+ *
+ * @param parser The ArgumentParser instance.
+ * @param handle The handle returned by add_arg.
+ * @return The value of the argument.
+ *
+ * Example usage:
+ * ArgumentHandle output = add_arg(parser, 'o', "output", 1, 1, "default_output.txt", "Output file");
+ * const char *value = get_arg_h(parser, output);
+ */
+const char *get_arg_h(const ArgumentParser *parser, ArgumentHandle handle);
+
+/**
+ * Retrieves the value of a keyword argument through its handle, without a name lookup.
+ * Only valid after parse_args, which has already applied the default value.
+ *
+ * @param parser The ArgumentParser instance.
+ * @param handle The handle returned by add_kwarg.
+ * @return The value of the keyword argument.
+ *
+ * Example usage:
+ * ArgumentHandle count = add_kwarg(parser, 'c', "count", 0, "1", "Number of times");
+ * const char *value = get_kwarg_h(parser, count);
+ */
+const char *get_kwarg_h(const ArgumentParser *parser, ArgumentHandle handle);
+
+/**
+ * Retrieves the value of a flag argument through its handle, without a name lookup.
+ *
+ * @param parser The ArgumentParser instance.
+ * @param handle The handle returned by add_flag.
+ * @return The value of the flag argument.
+ *
+ * Example usage:
+ * ArgumentHandle verbose = add_flag(parser, 'v', "verbose", "Enable verbose mode");
+ * int value = get_flag_h(parser, verbose);
+ */
+int get_flag_h(const ArgumentParser *parser, ArgumentHandle handle);
+
+/**
+ * Sets the type an argument's value is converted to. parse_args converts the
+ * value (or the default) once and fails on input that does not convert.
+ *
+ * @param parser The ArgumentParser instance.
+ * @param handle The handle returned by add_arg or add_kwarg.
+ * @param type The type to convert to.
+ *
+ * Example usage:
+ * set_type(parser, add_kwarg(parser, 'c', "count", 0, "1", "Number of times"), VALUE_INT);
+ */
+void set_type(ArgumentParser *parser, ArgumentHandle handle, ValueType type);
+
+/**
+ * Makes an argument an enum restricted to a list of choices. Its converted
+ * value is the index of the choice given.
+ *
+ * @param parser The ArgumentParser instance.
+ * @param handle The handle returned by add_arg or add_kwarg.
+ * @param choices The comma-separated choices.
+ *
+ * Example usage:
+ * set_choices(parser, color, "red,blue,green");
+ */
+void set_choices(ArgumentParser *parser, ArgumentHandle handle, const char *choices);
+
+/**
+ * Lets every option fall back to an environment variable when it is not
+ * given on the command line: prefix followed by the option's long name in
+ * upper case, with '-' written as '_'. The environment is scanned once, here,
+ * and each variable under the prefix is matched to its option through the
+ * name index, so parsing never calls getenv. Call it again to pick up a
+ * changed environment. A flag is set by a value of 1, true, yes or on.
+ *
+ * @param parser The ArgumentParser instance.
+ * @param prefix The variable name prefix, such as "MYAPP_".
+ *
+ * Example usage:
+ * load_env(parser, "MYAPP_"); // --count falls back to $MYAPP_COUNT
+ */
+void load_env(ArgumentParser *parser, const char *prefix);
+
+/**
+ * Loads a config file whose lines are name = value pairs, keyed by long
+ * option name, that options fall back to after the environment and before
+ * their defaults. Blank lines, lines starting with '#' or ';' and [section]
+ * headers are skipped, a value may be double quoted, and names that are not
+ * options are ignored. The file is mapped and parsed once; its values stay on
+ * the parser for every later parse until load_config is called again.
+ *
+ * @param parser The ArgumentParser instance.
+ * @param path The path of the file.
+ * @return 0 on success, or -1 if the file cannot be read or its contents
+ * cannot be allocated.
+ *
+ * Example usage:
+ * load_config(parser, "/etc/myapp.conf");
+ */
+int load_config(ArgumentParser *parser, const char *path);
+
+/**
+ * Retrieves the converted integer value of a keyword argument. Also used for
+ * VALUE_BOOL, VALUE_ENUM and VALUE_SIZE arguments.
+ *
+ * @param parser The ArgumentParser instance.
+ * @param name The name of the keyword argument.
+ * @return The converted value, or 0 if there is none.
+ *
+ * Example usage:
+ * long long count = get_kwarg_int(parser, "count");
+ */
+long long get_kwarg_int(ArgumentParser *parser, const char *name);
+
+/**
+ * Retrieves the converted value of a VALUE_DOUBLE keyword argument.
+ *
+ * @param parser The ArgumentParser instance.
+ * @param name The name of the keyword argument.
+ * @return The converted value, or 0 if there is none.
+ *
+ * Example usage:
+ * double ratio = get_kwarg_double(parser, "ratio");
+ */
+double get_kwarg_double(ArgumentParser *parser, const char *name);
+
+/**
+ * Retrieves the converted integer value of an argument through its handle.
+ *
+ * @param parser The ArgumentParser instance.
+ * @param handle The handle returned by add_arg or add_kwarg.
+ * @return The converted value, or 0 if there is none.
+ */
+long long get_int_h(const ArgumentParser *parser, ArgumentHandle handle);
+
+/**
+ * Retrieves the converted floating point value of an argument through its handle.
+ *
+ * @param parser The ArgumentParser instance.
+ * @param handle The handle returned by add_arg or add_kwarg.
+ * @return The converted value, or 0 if there is none.
+ */
+double get_double_h(const ArgumentParser *parser, ArgumentHandle handle);
+
+/**
+ * Retrieves the values of a multi-value argument. They point into argv and are
+ * stored contiguously, so argv must outlive the parser's use of them.
+ *
+ * @param parser The ArgumentParser instance.
+ * @param name The name of the argument.
+ * @param count Receives the number of values.
+ * @return The values of the argument, or NULL if there are none.
+ *
+ * Example usage:
+ * add_arg(parser, 'i', "input", 1, NARGS_ONE_OR_MORE, NULL, "Input files");
+ * int count;
+ * char **inputs = get_arg_values(parser, "input", &count);
+ */
+char **get_arg_values(ArgumentParser *parser, const char *name, int *count);
+
+/**
+ * Retrieves the values of a multi-value argument through its handle.
+ *
+ * @param parser The ArgumentParser instance.
+ * @param handle The handle returned by add_arg.
+ * @param count Receives the number of values.
+ * @return The values of the argument, or NULL if there are none.
+ */
+char **get_values_h(const ArgumentParser *parser, ArgumentHandle handle, int *count);
+
+/**
+ * Looks up the handle of an argument by its long name.
+ *
+ * @param parser The ArgumentParser instance.
+ * @param name The name of the argument.
+ * @return The handle of the argument, or -1 if there is none.
+ */
+ArgumentHandle find_arg(const ArgumentParser *parser, const char *name);
+
+/**
+ * Retrieves the value of an argument from a result.
+ *
+ * @param result The ArgumentResult instance.
+ * @param handle The handle returned by add_arg, add_kwarg or find_arg.
+ * @return The value of the argument, or its default if it was not given.
+ */
+const char *get_result_value(const ArgumentResult *result, ArgumentHandle handle);
+
+/**
+ * Retrieves whether a flag was given, from a result.
+ *
+ * @param result The ArgumentResult instance.
+ * @param handle The handle returned by add_flag or find_arg.
+ * @return 1 if the flag is set, 0 otherwise.
+ */
+int get_result_flag(const ArgumentResult *result, ArgumentHandle handle);
+
+/**
+ * Retrieves the converted value of an integer-typed argument from a result.
+ *
+ * @param result The ArgumentResult instance.
+ * @param handle The handle of the argument.
+ * @return The converted value.
+ */
+long long get_result_int(const ArgumentResult *result, ArgumentHandle handle);
+
+/**
+ * Retrieves the converted value of a VALUE_DOUBLE argument from a result.
+ *
+ * @param result The ArgumentResult instance.
+ * @param handle The handle of the argument.
+ * @return The converted value.
+ */
+double get_result_double(const ArgumentResult *result, ArgumentHandle handle);
+
+/**
+ * Retrieves the values of a multi-value argument from a result.
+ *
+ * @param result The ArgumentResult instance.
+ * @param handle The handle of the argument.
+ * @param count Receives the number of values.
+ * @return The values of the argument, or NULL if there are none.
+ */
+char **get_result_values(const ArgumentResult *result, ArgumentHandle handle, int *count);
+
+/**
+ * Prints the help message, one aligned line per option with the help text
+ * wrapped to the terminal. It is themed according to the parser's color
+ * setting, so output to a pipe or file has no escape codes by default.
+ *
+ * @param parser The ArgumentParser instance.
+ * @param description Whether to print the description.
+ * @param usage Whether to print the usage.
+ * @param epilog Whether to print the epilog.
+ * @param group Whether
+ *
+ * Example usage:
+ * print_help(parser, 1, 1, 1, 0);
+ */
+void print_help(ArgumentParser *parser, int description, int usage, int epilog, int group);
+
+/**
+ * Renders the help message into a string. The text is cached on the parser
+ * and reused until an argument is added or changed, so serving it again
+ * costs nothing.
+ *
+ * @param parser The ArgumentParser instance.
+ * @param description Whether to include the description.
+ * @param usage Whether to include the usage.
+ * @param epilog Whether to include the epilog.
+ * @param group Whether
+ * @param length Receives the length of the text, or NULL.
+ * @return The help text, owned by the parser.
+ *
+ * Example usage:
+ * size_t length;
+ * const char *help = format_help(parser, 1, 1, 1, 0, &length);
+ */
+const char *format_help(ArgumentParser *parser, int description, int usage, int epilog, int group, size_t *length);
+
+/**
+ * Answers a shell completion request. When argv[1] is "--__complete", the
+ * words after it are treated as the command line typed so far and the
+ * candidates for its last word are printed one per line: long options from
+ * the sorted name list, subcommand names and the choices of --name=. Only
+ * subcommands named before the last word are built. parse_args calls this
+ * first and exits after a completion request, but calling it right after
+ * registering the arguments lets a program skip the rest of its startup.
+ *
+ * @param parser The ArgumentParser instance.
+ * @param argc The argument count.
+ * @param argv The argument vector.
+ * @return 1 if this was a completion request and it was answered, 0 otherwise.
+ *
+ * Example usage:
+ * if (complete_args(parser, argc, (const char *const *)argv))
+ *     return 0;
+ */
+int complete_args(ArgumentParser *parser, int argc, const char *const argv[]);
+
+/**
+ * Prints a completion script for the parser and all of its subcommands, so
+ * the shell can complete options without running the program.
+ *
+ * @param parser The ArgumentParser instance.
+ * @param shell "bash", "zsh" or "fish".
+ *
+ * Example usage:
+ * print_completion(parser, "bash");
+ */
+void print_completion(ArgumentParser *parser, const char *shell);
+
+/**
+ * Prints the help message.
+ *
+ * @param parser The ArgumentParser instance.
+ *
+ * Example usage:
+ * print_flag_help(parser, 1, 1, 1, 0);
+ */
+void print_arg_help(ArgumentParser *parser, int i);
+
+/**
+ * Prints the help message.
+ *
+ * @param parser The ArgumentParser instance.
+ *
+ * Example usage:
+ * print_flag_help(parser, 1, 1, 1, 0);
+ */
+void print_flag_help(ArgumentParser *parser, int i);
+
+/**
+ * Prints the help message.
+ *
+ * @param parser The ArgumentParser instance.
+ *
+ * Example usage:
+ * print_flag_help(parser, 1, 1, 1, 0);
+ */
+void print_kwarg_help(ArgumentParser *parser, int i);
+
+/**
+ * Frees the memory allocated for the ArgumentParser instance.
+ *
+ * @param parser The ArgumentParser instance.
+ *
+ * Example usage:
+ * free_parser(parser);
+ */
+void free_parser(ArgumentParser *parser);
+
+#pragma endregion // DECLARATIONS
+
+#pragma region DEFINATIONS
+
+ArgumentAllocator myargs_allocator = {malloc, realloc, free};
+
+/**
+ * Returns a timestamp in nanoseconds from a monotonic clock, so durations
+ * never go backwards when the system clock is set.
+ */
+unsigned long long myargs_ticks(void)
+{
+#if defined(_WIN32)
+    LARGE_INTEGER now, frequency;
+    QueryPerformanceCounter(&now);
+    QueryPerformanceFrequency(&frequency);
+    unsigned long long ticks = (unsigned long long)now.QuadPart, hz = (unsigned long long)frequency.QuadPart;
+    return ticks / hz * 1000000000ull + ticks % hz * 1000000000ull / hz;
+#elif defined(CLOCK_MONOTONIC)
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (unsigned long long)now.tv_sec * 1000000000ull + (unsigned long long)now.tv_nsec;
+#elif defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L
+    struct timespec now;
+    timespec_get(&now, TIME_UTC);
+    return (unsigned long long)now.tv_sec * 1000000000ull + (unsigned long long)now.tv_nsec;
+#else
+    // strict C99 without POSIX only has processor time
+    return (unsigned long long)((double)clock() * 1e9 / CLOCKS_PER_SEC);
+#endif
+}
+
+MYARGS_THREAD_LOCAL ArgumentStats myargs_stats;
+ArgumentProfile myargs_profiler;
+
+const ArgumentStats *myargs_get_stats(void)
+{
+    return &myargs_stats;
+}
+
+void myargs_reset_stats(void)
+{
+    memset(&myargs_stats, 0, sizeof(myargs_stats));
+}
+
+/**
+ * Converts seconds of ArgumentStats to the whole nanoseconds of a profile line.
+ */
+unsigned long long myargs_nanoseconds(double seconds)
+{
+    return (unsigned long long)(seconds * 1e9 + 0.5);
+}
+
+/**
+ * Appends to a profile line of MYARGS_PROFILE_LINE bytes, cutting it short
+ * rather than overflowing. The last two bytes stay free for the closing "}\n".
+ */
+void myargs_profile_vappend(char *line, size_t *length, const char *format, va_list args)
+{
+    size_t room = MYARGS_PROFILE_LINE - 2 - *length;
+    int written = vsnprintf(line + *length, room, format, args);
+    if (written > 0)
+        *length += (size_t)written < room ? (size_t)written : room - 1;
+}
+
+void myargs_profile_append(char *line, size_t *length, const char *format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    myargs_profile_vappend(line, length, format, args);
+    va_end(args);
+}
+
+/**
+ * Appends ,"key":"value" to a profile line, escaped for JSON, unless value is
+ * NULL.
+ */
+void myargs_profile_string(char *line, size_t *length, const char *key, const char *value)
+{
+    if (!value)
+        return;
+    myargs_profile_append(line, length, ",\"%s\":\"", key);
+    for (const unsigned char *c = (const unsigned char *)value; *c; c++)
+    {
+        if (*c == '"' || *c == '\\')
+            myargs_profile_append(line, length, "\\%c", *c);
+        else if (*c < 0x20)
+            myargs_profile_append(line, length, "\\u%04x", *c);
+        else
+            myargs_profile_append(line, length, "%c", *c);
+    }
+    myargs_profile_append(line, length, "\"");
+}
+
+/**
+ * Writes the totals of every phase when the program exits, then closes the
+ * profile.
+ */
+void myargs_profile_totals(void)
+{
+    static const char *const phases[] = {"init", "register", "parse", "help"};
+    FILE *out = myargs_profiler.out;
+    if (!out)
+        return;
+
+    const ArgumentStats *stats = &myargs_stats;
+    const double times[] = {stats->init_time, stats->register_time, stats->parse_time, stats->help_time};
+    fprintf(out, "{\"phase\":\"total\",\"ns\":%llu", myargs_nanoseconds(times[0] + times[1] + times[2] + times[3]));
+    for (int k = 0; k < 4; k++)
+        fprintf(out, ",\"%s_ns\":%llu,\"%s_calls\":%llu", phases[k], myargs_nanoseconds(times[k]), phases[k], (unsigned long long)stats->calls[k]);
+    fprintf(out, ",\"allocations\":%llu,\"frees\":%llu,\"bytes\":%llu,\"lookups\":%llu}\n", (unsigned long long)stats->allocations, (unsigned long long)stats->frees, (unsigned long long)stats->bytes, (unsigned long long)stats->lookups);
+
+    myargs_profiler.out = NULL;
+    if (out == stderr)
+        fflush(out);
+    else
+        fclose(out);
+}
+
+int myargs_start_profile(const char *path)
+{
+#ifndef MYARGS_PROFILING
+    (void)path;
+    return -1;
+#endif // MYARGS_PROFILING
+    myargs_profiler.checked = true;
+    if (myargs_profiler.out)
+        return 0;
+
+    FILE *out = stderr;
+    if (path && *path && strcmp(path, "-") != 0 && strcmp(path, "1") != 0 && !(out = fopen(path, "a")))
+        return -1;
+    myargs_profiler.out = out;
+    if (!myargs_profiler.reported)
+    {
+        myargs_profiler.reported = true;
+        atexit(myargs_profile_totals);
+    }
+    return 0;
+}
+
+/**
+ * Starts profile mode if MYARGS_PROFILE is set, reading it only once.
+ */
+void myargs_check_profile(void)
+{
+#ifndef MYARGS_PROFILING
+    return;
+#endif // MYARGS_PROFILING
+    if (myargs_profiler.checked)
+        return;
+    myargs_profiler.checked = true;
+    const char *path = getenv("MYARGS_PROFILE");
+    if (path && *path && myargs_start_profile(path) != 0)
+        fprintf(stderr, "Cannot open profile file: %s\n", path);
+}
+
+/**
+ * Marks the start of a phase. While nothing is counted this only clears
+ * phase.
+ */
+void myargs_phase_begin(ArgumentPhase *phase)
+{
+    phase->start = 0;
+    if (!MYARGS_COUNTING)
+        return;
+    phase->start = myargs_ticks();
+    phase->stats = myargs_stats;
+}
+
+/**
+ * Ends a phase started by myargs_phase_begin, adding its duration to
+ * myargs_stats. Unless event is NULL, as for the pieces of a fed command
+ * line, it also counts a call and, in profile mode, writes the phase's JSON
+ * line: the duration and heap use since the start, then the fields of
+ * format, which continues the object (",\"tokens\":%d").
+ */
+void myargs_phase_end(const ArgumentPhase *phase, ArgumentPhaseKind kind, const char *event, const ArgumentParser *parser, const char *name, const char *format, ...)
+{
+    if (!phase->start)
+        return;
+    unsigned long long ns = myargs_ticks() - phase->start;
+    double *times[] = {&myargs_stats.init_time, &myargs_stats.register_time, &myargs_stats.parse_time, &myargs_stats.help_time};
+    *times[kind] += (double)ns / 1e9;
+    if (!event)
+        return;
+    myargs_stats.calls[kind]++;
+    if (!myargs_profiler.out)
+        return;
+
+    // the line is built first and written in one call, so the lines of
+    // threads parsing at the same time do not interleave
+    char line[MYARGS_PROFILE_LINE];
+    size_t length = 0;
+    myargs_profile_append(line, &length, "{\"phase\":\"%s\"", event);
+    myargs_profile_string(line, &length, "program", parser ? parser->program : NULL);
+    myargs_profile_string(line, &length, "name", name);
+    myargs_profile_append(line, &length, ",\"ns\":%llu,\"allocations\":%llu,\"bytes\":%llu", ns, (unsigned long long)(myargs_stats.allocations - phase->stats.allocations), (unsigned long long)(myargs_stats.bytes - phase->stats.bytes));
+    if (format)
+    {
+        va_list args;
+        va_start(args, format);
+        myargs_profile_vappend(line, &length, format, args);
+        va_end(args);
+    }
+    line[length++] = '}';
+    line[length++] = '\n';
+    fwrite(line, 1, length, myargs_profiler.out);
+}
+
+void myargs_set_allocator(void *(*malloc_fn)(size_t), void *(*realloc_fn)(void *, size_t), void (*free_fn)(void *))
+{
+    myargs_allocator.allocate = malloc_fn ? malloc_fn : malloc;
+    myargs_allocator.reallocate = realloc_fn ? realloc_fn : realloc;
+    myargs_allocator.release = free_fn ? free_fn : free;
+}
+
+/**
+ * Allocates size bytes through the current allocator.
+ */
+void *myargs_heap_alloc(size_t size)
+{
+    MYARGS_COUNT(allocations, 1);
+    MYARGS_COUNT(bytes, size);
+    return myargs_allocator.allocate(size);
+}
+
+/**
+ * Resizes a block through the current allocator.
+ */
+void *myargs_heap_realloc(void *ptr, size_t size)
+{
+    MYARGS_COUNT(allocations, 1);
+    MYARGS_COUNT(bytes, size);
+    return myargs_allocator.reallocate(ptr, size);
+}
+
+/**
+ * Releases a block through the current allocator.
+ */
+void myargs_heap_free(void *ptr)
+{
+    if (!ptr)
+        return;
+    MYARGS_COUNT(frees, 1);
+    myargs_allocator.release(ptr);
+}
+
+/**
+ * Returns the first usable byte of an arena block.
+ */
+char *myargs_arena_data(ArgumentArena *arena)
+{
+    char *data = (char *)(arena + 1);
+    return data + (MYARGS_ARENA_ALIGN - (size_t)data % MYARGS_ARENA_ALIGN) % MYARGS_ARENA_ALIGN;
+}
+
+/**
+ * Allocates a fresh heap block able to hold at least size bytes.
+ */
+ArgumentArena *myargs_arena_block(size_t size)
+{
+    ArgumentArena *block = (ArgumentArena *)myargs_heap_alloc(sizeof(ArgumentArena) + MYARGS_ARENA_ALIGN + size);
+    if (!block)
+        return NULL;
+    block->next = NULL;
+    block->size = size;
+    block->used = 0;
+    block->owned = true;
+    return block;
+}
+
+/**
+ * Turns a caller buffer into an arena block the parser never frees.
+ *
+ * @return The block, or NULL if the buffer is too small to hold one.
+ */
+ArgumentArena *myargs_arena_from_buffer(void *buffer, size_t size)
+{
+    size_t offset = (MYARGS_ARENA_ALIGN - (size_t)buffer % MYARGS_ARENA_ALIGN) % MYARGS_ARENA_ALIGN;
+    if (!buffer || size <= offset + sizeof(ArgumentArena) + MYARGS_ARENA_ALIGN)
+        return NULL;
+
+    ArgumentArena *block = (ArgumentArena *)((char *)buffer + offset);
+    block->next = NULL;
+    block->size = size - offset - sizeof(ArgumentArena) - MYARGS_ARENA_ALIGN;
+    block->used = 0;
+    block->owned = false;
+    return block;
+}
+
+/**
+ * Bump-allocates size bytes from the arena *head. When the current block is
+ * full a new heap block of at least twice its size is chained in front of it.
+ */
+void *myargs_arena_alloc(ArgumentArena **head, size_t size)
+{
+    ArgumentArena *arena = *head;
+    size = (size + MYARGS_ARENA_ALIGN - 1) & ~(size_t)(MYARGS_ARENA_ALIGN - 1);
+    if (arena->size - arena->used < size)
+    {
+        size_t block = arena->size * 2;
+        if (block < size)
+            block = size;
+        ArgumentArena *next = myargs_arena_block(block);
+        if (!next)
+            return NULL;
+        next->next = arena;
+        *head = arena = next;
+    }
+
+    void *ptr = myargs_arena_data(arena) + arena->used;
+    arena->used += size;
+    return ptr;
+}
+
+/**
+ * Rewinds the arena *head for reuse. The largest block is kept and emptied,
+ * the other heap blocks are freed.
+ */
+void myargs_arena_reset(ArgumentArena **head)
+{
+    ArgumentArena *largest = *head;
+    for (ArgumentArena *arena = *head; arena; arena = arena->next)
+    {
+        if (arena->size > largest->size)
+            largest = arena;
+    }
+
+    ArgumentArena *arena = *head;
+    while (arena)
+    {
+        ArgumentArena *next = arena->next;
+        if (arena != largest && arena->owned)
+            myargs_heap_free(arena);
+        arena = next;
+    }
+
+    if (largest)
+    {
+        largest->next = NULL;
+        largest->used = 0;
+    }
+    *head = largest;
+}
+
+/**
+ * Frees every heap block of the arena *head.
+ */
+void myargs_arena_free(ArgumentArena **head)
+{
+    ArgumentArena *arena = *head;
+    while (arena)
+    {
+        ArgumentArena *next = arena->next;
+        if (arena->owned)
+            myargs_heap_free(arena);
+        arena = next;
+    }
+    *head = NULL;
+}
+
+/**
+ * Allocates size bytes from the parser's arena, or from the heap when the
+ * parser has no arena.
+ */
+void *myargs_alloc(ArgumentParser *parser, size_t size)
+{
+    if (!parser->arena)
+        return myargs_heap_alloc(size);
+    return myargs_arena_alloc(&parser->arena, size);
+}
+
+/**
+ * Allocates size bytes for the current parse from the result's arena,
+ * creating its first block on demand.
+ */
+void *myargs_result_alloc(ArgumentResult *result, size_t size)
+{
+    if (!result->arena)
+    {
+        result->arena = myargs_arena_block(size > MYARGS_ARENA_BLOCK_SIZE ? size : MYARGS_ARENA_BLOCK_SIZE);
+        if (!result->arena)
+            return NULL;
+    }
+    return myargs_arena_alloc(&result->arena, size);
+}
+
+/**
+ * Resizes a block returned by myargs_alloc. In arena mode the last allocation
+ * is grown in place when it fits; otherwise the contents are copied over.
+ */
+void *myargs_realloc(ArgumentParser *parser, void *ptr, size_t old_size, size_t new_size)
+{
+    ArgumentArena *arena = parser->arena;
+    if (!arena)
+        return myargs_heap_realloc(ptr, new_size);
+
+    if (ptr)
+    {
+        char *data = myargs_arena_data(arena);
+        size_t old_aligned = (old_size + MYARGS_ARENA_ALIGN - 1) & ~(size_t)(MYARGS_ARENA_ALIGN - 1);
+        size_t new_aligned = (new_size + MYARGS_ARENA_ALIGN - 1) & ~(size_t)(MYARGS_ARENA_ALIGN - 1);
+        if ((char *)ptr + old_aligned == data + arena->used && (char *)ptr - data + new_aligned <= arena->size)
+        {
+            arena->used = (char *)ptr - data + new_aligned;
+            return ptr;
+        }
+    }
+
+    void *resized = myargs_alloc(parser, new_size);
+    if (resized && ptr)
+        memcpy(resized, ptr, old_size < new_size ? old_size : new_size);
+    return resized;
+}
+
+/**
+ * Frees a block returned by myargs_alloc. A no-op in arena mode, where memory
+ * is only released by free_parser.
+ */
+void myargs_free(ArgumentParser *parser, void *ptr)
+{
+    if (!parser->arena)
+        myargs_heap_free(ptr);
+}
+
+/**
+ * Duplicates the first length bytes of a string into parser-owned memory.
+ */
+char *myargs_strndup(ArgumentParser *parser, const char *str, size_t length)
+{
+    char *copy = (char *)myargs_alloc(parser, length + 1);
+    if (!copy)
+    {
+        fprintf(stderr, "Out of memory\n");
+        exit(EXIT_FAILURE);
+    }
+    memcpy(copy, str, length);
+    copy[length] = '\0';
+    return copy;
+}
+
+/**
+ * Duplicates a string into parser-owned memory. NULL is passed through;
+ * running out of memory exits, as registration always has.
+ */
+char *myargs_strdup(ArgumentParser *parser, const char *str)
+{
+    return str ? myargs_strndup(parser, str, strlen(str)) : NULL;
+}
+
+/**
+ * Makes sure a buffer has room for extra more bytes plus the terminator.
+ */
+void myargs_buffer_reserve(ArgumentBuffer *buffer, size_t extra)
+{
+    if (buffer->length + extra < buffer->capacity)
+        return;
+
+    size_t capacity = buffer->capacity ? buffer->capacity : 256;
+    while (capacity <= buffer->length + extra)
+        capacity *= 2;
+    char *data = (char *)myargs_heap_realloc(buffer->data, capacity);
+    if (!data)
+    {
+        fprintf(stderr, "Out of memory\n");
+        exit(EXIT_FAILURE);
+    }
+    buffer->data = data;
+    buffer->capacity = capacity;
+}
+
+/**
+ * Appends formatted text to a buffer, growing it only when the text does not
+ * fit in what is left.
+ */
+void myargs_buffer_printf(ArgumentBuffer *buffer, const char *format, ...)
+{
+    va_list args;
+    myargs_buffer_reserve(buffer, 0);
+    va_start(args, format);
+    int written = vsnprintf(buffer->data + buffer->length, buffer->capacity - buffer->length, format, args);
+    va_end(args);
+    if (written < 0)
+        return;
+
+    if (buffer->length + (size_t)written >= buffer->capacity)
+    {
+        myargs_buffer_reserve(buffer, (size_t)written);
+        va_start(args, format);
+        vsnprintf(buffer->data + buffer->length, buffer->capacity - buffer->length, format, args);
+        va_end(args);
+    }
+    buffer->length += (size_t)written;
+}
+
+/**
+ * Drops the cached help text and layout after the arguments change.
+ */
+void myargs_invalidate_help(ArgumentParser *parser)
+{
+    myargs_heap_free(parser->help_text);
+    parser->help_text = NULL;
+    parser->help_length = 0;
+    parser->help_column = 0;
+}
+
+/**
+ * Whether help is rendered with color: the parser's color setting or, for
+ * MYARGS_COLOR_AUTO, whether stdout is a terminal and NO_COLOR is unset.
+ */
+bool myargs_use_color(const ArgumentParser *parser)
+{
+    if (parser->color != MYARGS_COLOR_AUTO)
+        return parser->color == MYARGS_COLOR_ALWAYS;
+    if (getenv("NO_COLOR"))
+        return false;
+#ifdef _WIN32
+    return _isatty(1) != 0;
+#else
+    return isatty(STDOUT_FILENO) != 0;
+#endif // _WIN32
+}
+
+/**
+ * Returns the width help is wrapped to: help_width if set, else $COLUMNS,
+ * else the width of the terminal, else 80.
+ */
+size_t myargs_help_width(const ArgumentParser *parser)
+{
+    if (parser->help_width > 0)
+        return (size_t)parser->help_width;
+    const char *columns = getenv("COLUMNS");
+    if (columns && atoi(columns) > 0)
+        return (size_t)atoi(columns);
+#ifdef TIOCGWINSZ
+    struct winsize size;
+    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &size) == 0 && size.ws_col > 0)
+        return size.ws_col;
+#endif // TIOCGWINSZ
+    return 80;
+}
+
+/**
+ * Returns the plain-text width of an option's "-s,--name" cell.
+ */
+size_t myargs_option_width(const Argument *argument)
+{
+    return (argument->sym != '0' ? 3 : 0) + 2 + strlen(argument->name);
+}
+
+/**
+ * Measures every option once and stores the width of the option column,
+ * capped so the help text keeps at least half of the line.
+ */
+void myargs_layout_help(ArgumentParser *parser, size_t width)
+{
+    size_t column = 0;
+    for (int i = 0; i < parser->count; i++)
+    {
+        size_t cell = myargs_option_width(&parser->arguments[i]);
+        if (cell > column)
+            column = cell;
+    }
+    parser->help_column = column < width / 2 ? column : width / 2;
+}
+
+/**
+ * Appends the words of text wrapped to width, continuing on new lines
+ * indented by indent. *column tracks the current position on the line; the
+ * theme code is reapplied on every line so colors never span a line break.
+ */
+void myargs_buffer_wrap(ArgumentBuffer *buffer, const char *text, const char *code, const char *reset, size_t indent, size_t width, size_t *column)
+{
+    bool open = false;
+    while (*text)
+    {
+        while (*text == ' ')
+            text++;
+        if (!*text)
+            break;
+
+        size_t length = strcspn(text, " ");
+        if (*column > indent && *column + 1 + length > width)
+        {
+            myargs_buffer_printf(buffer, "%s\n%*s", open ? reset : "", (int)indent, "");
+            open = false;
+            *column = indent;
+        }
+        else if (*column > indent)
+        {
+            myargs_buffer_printf(buffer, " ");
+            (*column)++;
+        }
+
+        myargs_buffer_printf(buffer, "%s%.*s", open ? "" : code, (int)length, text);
+        open = true;
+        *column += length;
+        text += length;
+    }
+    if (open)
+        myargs_buffer_printf(buffer, "%s", reset);
+}
+
+/**
+ * Appends the aligned help line of argument i: the option cell right-aligned
+ * to the layout's column, then its help and a bracketed summary of its
+ * choices, requirement and default, wrapped to width.
+ */
+void myargs_format_option(ArgumentParser *parser, ArgumentBuffer *buffer, int i, bool color, size_t width)
+{
+    const Argument *argument = &parser->arguments[i];
+    const char *reset = color ? NC : "";
+    size_t column = parser->help_column;
+    size_t cell = myargs_option_width(argument);
+
+    myargs_buffer_printf(buffer, "%*s", (int)(column > cell ? column - cell : 0), "");
+    if (argument->sym != '0')
+        myargs_buffer_printf(buffer, "%s-%c%s,", color ? ST : "", argument->sym, reset);
+    myargs_buffer_printf(buffer, "%s--%s%s %s:%s ", color ? NT : "", argument->name, reset, color ? CC : "", reset);
+
+    // a column too wide for the line leaves the help unwrapped
+    size_t indent = (column > cell ? column : cell) + 3;
+    if (indent + 20 > width)
+        width = (size_t)-1;
+    size_t position = indent;
+    if (argument->help)
+        myargs_buffer_wrap(buffer, argument->help, color ? HT : "", reset, indent, width, &position);
+
+    ArgumentBuffer summary = {NULL, 0, 0};
+    if (argument->type == FLAG)
+    {
+        myargs_buffer_printf(&summary, "[implicit: \"true\", default: false]");
+    }
+    else
+    {
+        const char *separator = "[";
+        if (argument->choices)
+        {
+            myargs_buffer_printf(&summary, "%sallowed: <", separator);
+            for (const char *choice = argument->choices; *choice; choice++)
+                myargs_buffer_printf(&summary, *choice == ',' ? ", " : "%c", *choice);
+            myargs_buffer_printf(&summary, ">");
+            separator = ", ";
+        }
+        if (argument->count > 1)
+        {
+            myargs_buffer_printf(&summary, "%snargs: %d", separator, argument->count);
+            separator = ", ";
+        }
+        else if (argument->count < 0)
+        {
+            myargs_buffer_printf(&summary, "%snargs: %s", separator, argument->count == NARGS_OPTIONAL ? "?" : argument->count == NARGS_ZERO_OR_MORE ? "*" : "+");
+            separator = ", ";
+        }
+        if (argument->required)
+        {
+            myargs_buffer_printf(&summary, "%srequired", separator);
+            separator = ", ";
+        }
+        else if (argument->def_val)
+        {
+            myargs_buffer_printf(&summary, "%sdefault: %s", separator, argument->def_val);
+            separator = ", ";
+        }
+        if (summary.length)
+            myargs_buffer_printf(&summary, "]");
+    }
+    if (summary.length)
+        myargs_buffer_wrap(buffer, summary.data, color ? (argument->required ? RT : DT) : "", reset, indent, width, &position);
+    myargs_heap_free(summary.data);
+    myargs_buffer_printf(buffer, "\n");
+}
+
+/**
+ * Writes text to stdout with a single call.
+ */
+void myargs_write_help(const char *text, size_t length)
+{
+    fwrite(text, 1, length, stdout);
+    fflush(stdout);
+}
+
+/**
+ * Prints the aligned help line of argument i on its own.
+ */
+void myargs_print_option(ArgumentParser *parser, int i)
+{
+    bool color = myargs_use_color(parser);
+    size_t width = myargs_help_width(parser);
+    if (!parser->help_column)
+        myargs_layout_help(parser, width);
+
+    ArgumentBuffer buffer = {NULL, 0, 0};
+    myargs_format_option(parser, &buffer, i, color, width);
+    myargs_write_help(buffer.data, buffer.length);
+    myargs_heap_free(buffer.data);
+}
+
+/**
+ * Fails when a frozen parser is about to be modified.
+ */
+void myargs_check_mutable(const ArgumentParser *parser, const char *what)
+{
+    if (parser->frozen)
+    {
+        fprintf(stderr, "Cannot %s: the parser is frozen\n", what);
+        exit(EXIT_FAILURE);
+    }
+}
+
+/**
+ * Clears the errors of a result before a new parse.
+ */
+void myargs_clear_diagnostics(ArgumentResult *result)
+{
+    result->diagnostics.count = 0;
+    result->diagnostics.dropped = 0;
+    result->diagnostics.used = 0;
+    result->diagnostics.row = -1;
+    result->diagnostics.row_status = ARGUMENT_OK;
+}
+
+/**
+ * Copies length bytes of str into the text of a result's diagnostics,
+ * truncating it to the room that is left.
+ */
+const char *myargs_diagnostic_text(ArgumentDiagnostics *diagnostics, const char *str, size_t length)
+{
+    if (diagnostics->used >= MYARGS_ERROR_TEXT)
+        return "";
+    size_t room = MYARGS_ERROR_TEXT - diagnostics->used - 1;
+    char *copy = diagnostics->text + diagnostics->used;
+    length = length < room ? length : room;
+    memcpy(copy, str, length);
+    copy[length] = '\0';
+    diagnostics->used += length + 1;
+    return copy;
+}
+
+/**
+ * Reports an error about the first length bytes of argument. With
+ * exit_on_error set on the result's parser the message is printed and the
+ * process exits, as it always did, except during parse_args_batch, where one
+ * bad row must not end the others; otherwise the error is recorded in the
+ * result's diagnostics with its row and parsing goes on. Neither allocates.
+ */
+void myargs_error(ArgumentResult *result, ArgumentStatus status, const char *argument, size_t length, const char *format, ...)
+{
+    char message[MYARGS_ERROR_TEXT];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(message, sizeof(message), format, args);
+    va_end(args);
+
+    ArgumentDiagnostics *diagnostics = &result->diagnostics;
+    if (!result->parser || (result->parser->exit_on_error && diagnostics->row < 0))
+    {
+        fprintf(stderr, "%s\n", message);
+        exit(EXIT_FAILURE);
+    }
+
+    if (diagnostics->row_status == ARGUMENT_OK)
+        diagnostics->row_status = status;
+    if (diagnostics->count == MYARGS_MAX_ERRORS)
+    {
+        diagnostics->dropped++;
+        return;
+    }
+    ArgumentError_t *error = &diagnostics->errors[diagnostics->count++];
+    error->status = status;
+    error->row = diagnostics->row;
+    error->argument = myargs_diagnostic_text(diagnostics, argument, length);
+    error->message = myargs_diagnostic_text(diagnostics, message, strlen(message));
+}
+
+/**
+ * Returns the status of the errors recorded in a result: that of the first
+ * one, or ARGUMENT_OK.
+ */
+ArgumentStatus myargs_status(const ArgumentResult *result)
+{
+    return result->diagnostics.count ? result->diagnostics.errors[0].status : ARGUMENT_OK;
+}
+
+/**
+ * Makes room for one more argument, growing the array and the parser's own
+ * result geometrically, and clears the new argument's parsed state.
+ */
+void myargs_grow_arguments(ArgumentParser *parser)
+{
+    myargs_check_mutable(parser, "add an argument");
+    myargs_invalidate_help(parser);
+    if (parser->count == parser->capacity)
+    {
+        int capacity = parser->capacity ? parser->capacity * 2 : 8;
+        parser->arguments = (Argument *)myargs_realloc(parser, parser->arguments, sizeof(Argument) * parser->capacity, sizeof(Argument) * capacity);
+        parser->result.values = (ArgumentValue *)myargs_realloc(parser, parser->result.values, sizeof(ArgumentValue) * parser->capacity, sizeof(ArgumentValue) * capacity);
+        parser->sorted = (int *)myargs_realloc(parser, parser->sorted, sizeof(int) * parser->capacity, sizeof(int) * capacity);
+        parser->capacity = capacity;
+        parser->result.capacity = capacity;
+    }
+    memset(&parser->result.values[parser->count], 0, sizeof(ArgumentValue));
+}
+
+/**
+ * Clears every field of a result that has no storage yet.
+ */
+void myargs_clear_result(ArgumentResult *result)
+{
+    result->values = NULL;
+    result->capacity = 0;
+    result->owns_values = false;
+    result->arena = NULL;
+    result->value_pool = NULL;
+    result->value_pool_size = 0;
+    result->value_pool_used = 0;
+    result->files = NULL;
+    result->parser = NULL;
+    result->command = -1;
+    result->command_offset = 0;
+    result->streaming = false;
+    result->open_argument = -1;
+    result->open_start = 0;
+    myargs_clear_diagnostics(result);
+}
+
+/**
+ * Gives every field of a parser its default, before parser,
+ * init_parser_arena or load_schema apply their own settings.
+ */
+void myargs_init_parser(ArgumentParser *parser)
+{
+    parser->program = NULL;
+    parser->usage = NULL;
+    parser->description = NULL;
+    parser->epilog = NULL;
+    parser->argument_default = NULL;
+    parser->arguments = NULL;
+    parser->count = 0;
+    parser->capacity = 0;
+    parser->arena = NULL;
+    parser->prefix_char = '-';
+    parser->add_help = true;
+    parser->allow_abbrev = true;
+    parser->exit_on_error = true;
+    parser->zero_copy = false;
+    parser->lazy = false;
+    parser->fromfile_prefix_char = '\0';
+    parser->index = NULL;
+    parser->index_size = 0;
+    parser->sorted = NULL;
+    parser->sorted_count = 0;
+    memset(parser->syms, -1, sizeof(parser->syms));
+    myargs_clear_result(&parser->result);
+    parser->frozen = false;
+    parser->help_text = NULL;
+    parser->help_length = 0;
+    parser->help_flags = 0;
+    parser->help_columns = 0;
+    parser->help_column = 0;
+    parser->color = MYARGS_COLOR_AUTO;
+    parser->help_width = 0;
+    parser->commands = NULL;
+    parser->command_count = 0;
+    parser->command_capacity = 0;
+    parser->command_index = NULL;
+    parser->command_index_size = 0;
+    parser->schema = NULL;
+    parser->hashes = NULL;
+    parser->name_offsets = NULL;
+    parser->kinds = NULL;
+    parser->names = NULL;
+#ifdef MYARGS_PROFILING
+    parser->started = myargs_ticks();
+#else
+    parser->started = 0;
+#endif // MYARGS_PROFILING
+}
+
+void parser(ArgumentParser *parser, const char *format, ...)
+{
+    ArgumentPhase phase;
+    myargs_check_profile();
+    myargs_phase_begin(&phase);
+    myargs_init_parser(parser);
+
+    if (format != NULL)
+    {
+        // Initialize variadic argument list
+        va_list args;
+
+        va_start(args, format);
+
+        size_t format_lenght = strlen(format);
+        char cc;
+
+        for (size_t i = 0; i < format_lenght; i++)
+        {
+            if (format[i] == '%')
+            {
+                i++;
+
+                if (format[i] == 'p') // program
+                {
+                    parser->program = myargs_strdup(parser, va_arg(args, const char *));
+                }
+                else if (format[i] == 'u') // usage
+                {
+                    parser->usage = myargs_strdup(parser, va_arg(args, const char *));
+                }
+                else if (format[i] == 'd') // description
+                {
+                    parser->description = myargs_strdup(parser, va_arg(args, const char *));
+                }
+                else if (format[i] == 'D') // argument_default
+                {
+                    parser->argument_default = myargs_strdup(parser, va_arg(args, const char *));
+                }
+                else if (format[i] == 'e') // epilog
+                {
+                    parser->epilog = myargs_strdup(parser, va_arg(args, const char *));
+                }
+                else if (format[i] == 'c') // prefix_chars
+                {
+                    parser->prefix_char = va_arg(args, int);
+                }
+                else if (format[i] == 'h') // add_help
+                {
+                    parser->add_help = va_arg(args, int);
+                }
+                else if (format[i] == 'a') // allow_abbrev
+                {
+                    parser->allow_abbrev = va_arg(args, int);
+                }
+                else if (format[i] == 'r') // exit_on_error
+                {
+                    parser->exit_on_error = va_arg(args, int);
+                }
+                else if (format[i] == 'z') // zero_copy
+                {
+                    parser->zero_copy = va_arg(args, int);
+                }
+                else if (format[i] == 'l') // lazy
+                {
+                    parser->lazy = va_arg(args, int);
+                }
+                else if (format[i] == 'f') // fromfile_prefix_char
+                {
+                    parser->fromfile_prefix_char = va_arg(args, int);
+                }
+            }
+        }
+        // Clean up argument list
+        va_end(args);
+    }
+    // the help flag gets a record of its own
+    myargs_phase_end(&phase, PHASE_INIT, "parser", parser, NULL, NULL);
+
+    if (parser->add_help)
+    {
+        add_flag(parser, 'h', "help", "Shows this help Menu");
+    }
+};
+
+void init_parser(ArgumentParser *parser, const char *program, const char *usage, const char *description, const char *epilog)
+{
+    init_parser_arena(parser, NULL, 0, program, usage, description, epilog);
+}
+
+void init_parser_arena(ArgumentParser *parser, void *buffer, size_t size, const char *program, const char *usage, const char *description, const char *epilog)
+{
+    ArgumentPhase phase;
+    myargs_check_profile();
+    myargs_phase_begin(&phase);
+    myargs_init_parser(parser);
+
+    if (size > 0)
+    {
+        parser->arena = myargs_arena_from_buffer(buffer, size);
+        if (!parser->arena)
+            parser->arena = myargs_arena_block(size < MYARGS_ARENA_BLOCK_SIZE ? MYARGS_ARENA_BLOCK_SIZE : size);
+    }
+
+    parser->program = myargs_strdup(parser, program);
+    parser->usage = myargs_strdup(parser, usage);
+    parser->description = myargs_strdup(parser, description);
+    parser->epilog = myargs_strdup(parser, epilog);
+    myargs_phase_end(&phase, PHASE_INIT, "init_parser", parser, NULL, NULL);
+
+    if (parser->add_help)
+    {
+        add_flag(parser, 'h', "help", "Shows this help Menu");
+    }
+}
+
+/**
+ * Hashes the first length bytes of a name (FNV-1a).
+ */
+unsigned int myargs_hash(const char *name, size_t length)
+{
+    unsigned int hash = 2166136261u;
+    for (size_t i = 0; i < length; i++)
+    {
+        hash ^= (unsigned char)name[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+/**
+ * Compares a name with the first length bytes of key, ordering them as
+ * strcmp would if key ended there.
+ */
+int myargs_compare_name(const char *name, const char *key, size_t length)
+{
+    int order = strncmp(name, key, length);
+    return order ? order : name[length] != '\0';
+}
+
+/**
+ * Returns the position of the first name in the sorted list that is not
+ * ordered before the first length bytes of key. Every name that key is a
+ * prefix of follows from there.
+ */
+int myargs_lower_bound(const ArgumentParser *parser, const char *key, size_t length)
+{
+    int low = 0;
+    int high = parser->sorted_count;
+    while (low < high)
+    {
+        int middle = low + (high - low) / 2;
+        if (myargs_compare_name(parser->arguments[parser->sorted[middle]].name, key, length) < 0)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+    return low;
+}
+
+/**
+ * Inserts argument i into the name index, the sorted name list and the
+ * symbol table, growing the index so that it is never more than half full. Earlier registrations win on
+ * duplicate names or symbols, matching the old first-match linear scan.
+ */
+void myargs_index_argument(ArgumentParser *parser, int i, char sym)
+{
+    Argument *argument = &parser->arguments[i];
+    size_t length = strlen(argument->name);
+    argument->hash = myargs_hash(argument->name, length);
+
+    int position = myargs_lower_bound(parser, argument->name, length);
+    if (position == parser->sorted_count || strcmp(parser->arguments[parser->sorted[position]].name, argument->name) != 0)
+    {
+        memmove(parser->sorted + position + 1, parser->sorted + position, sizeof(int) * (size_t)(parser->sorted_count - position));
+        parser->sorted[position] = i;
+        parser->sorted_count++;
+    }
+
+    if (sym && parser->syms[(unsigned char)sym] < 0)
+    {
+        parser->syms[(unsigned char)sym] = i;
+    }
+
+    if ((i + 1) * 2 > parser->index_size)
+    {
+        int size = parser->index_size ? parser->index_size * 2 : 16;
+        myargs_free(parser, parser->index);
+        parser->index = (int *)myargs_alloc(parser, sizeof(int) * size);
+        if (!parser->index)
+        {
+            fprintf(stderr, "Out of memory\n");
+            exit(EXIT_FAILURE);
+        }
+        memset(parser->index, -1, sizeof(int) * size);
+        parser->index_size = size;
+
+        // rehash everything registered before argument i
+        for (int j = 0; j < i; j++)
+        {
+            unsigned int slot = parser->arguments[j].hash & (size - 1);
+            while (parser->index[slot] >= 0)
+                slot = (slot + 1) & (size - 1);
+            parser->index[slot] = j;
+        }
+    }
+
+    unsigned int mask = parser->index_size - 1;
+    unsigned int slot = argument->hash & mask;
+    while (parser->index[slot] >= 0)
+    {
+        Argument *other = &parser->arguments[parser->index[slot]];
+        if (other->hash == argument->hash && strcmp(other->name, argument->name) == 0)
+            return;
+        slot = (slot + 1) & mask;
+    }
+    parser->index[slot] = i;
+}
+
+/**
+ * Looks up an argument by its long name. The name does not need to be NUL
+ * terminated, so a token such as "count=5" can be looked up in place.
+ *
+ * @return The index of the argument, or -1 if there is none.
+ */
+int myargs_find(const ArgumentParser *parser, const char *name, size_t length)
+{
+    if (parser->index_size == 0)
+        return -1;
+
+    MYARGS_COUNT(lookups, 1);
+    unsigned int hash = myargs_hash(name, length);
+    unsigned int mask = parser->index_size - 1;
+    if (parser->names)
+    {
+        // a frozen parser probes the dense hashes and the name pool, not the records
+        for (unsigned int slot = hash & mask; parser->index[slot] >= 0; slot = (slot + 1) & mask)
+        {
+            int i = parser->index[slot];
+            const unsigned char *entry = (const unsigned char *)parser->names + parser->name_offsets[i];
+            if (parser->hashes[i] == hash && (entry[0] < 255 ? entry[0] == length && memcmp(entry + 1, name, length) == 0 : strncmp((const char *)entry + 1, name, length) == 0 && entry[1 + length] == '\0'))
+                return i;
+        }
+        return -1;
+    }
+    for (unsigned int slot = hash & mask; parser->index[slot] >= 0; slot = (slot + 1) & mask)
+    {
+        const Argument *argument = &parser->arguments[parser->index[slot]];
+        if (argument->hash == hash && strncmp(argument->name, name, length) == 0 && argument->name[length] == '\0')
+            return parser->index[slot];
+    }
+    return -1;
+}
+
+/**
+ * Looks up an argument by its short symbol.
+ *
+ * @return The index of the argument, or -1 if there is none.
+ */
+int myargs_find_sym(const ArgumentParser *parser, char sym)
+{
+    MYARGS_COUNT(lookups, 1);
+    return parser->syms[(unsigned char)sym];
+}
+
+/**
+ * Looks up the argument whose long name starts with the first length bytes
+ * of name, with two binary searches' worth of comparisons: the matches are
+ * adjacent in the sorted list, so only the first two need checking.
+ *
+ * @return The index of the argument, -1 if no name starts with it, or -2 if several do.
+ */
+int myargs_find_prefix(const ArgumentParser *parser, const char *name, size_t length)
+{
+    if (length == 0)
+        return -1;
+
+    MYARGS_COUNT(lookups, 1);
+    int position = myargs_lower_bound(parser, name, length);
+    if (position == parser->sorted_count || strncmp(parser->arguments[parser->sorted[position]].name, name, length) != 0)
+        return -1;
+    if (position + 1 < parser->sorted_count && strncmp(parser->arguments[parser->sorted[position + 1]].name, name, length) == 0)
+        return -2;
+    return parser->sorted[position];
+}
+
+/**
+ * Returns the number of single-character edits, counting a swap of two
+ * adjacent characters as one, that turn a into b. Names longer than 63
+ * bytes are treated as too far apart to compare. Once the distance is known
+ * to be at least bound, bound is returned without finishing the table, so a
+ * flood of unknown options stays cheap; any result of bound or more only
+ * means "not closer than bound".
+ */
+size_t myargs_distance(const char *a, size_t m, const char *b, size_t n, size_t bound)
+{
+    if (m > 63 || n > 63)
+        return (size_t)-1;
+    if ((m > n ? m - n : n - m) >= bound)
+        return bound;
+
+    size_t rows[3][64];
+    size_t *before = rows[0], *previous = rows[1], *current = rows[2];
+    size_t previous_min = 0;
+    for (size_t j = 0; j <= n; j++)
+        previous[j] = j;
+    for (size_t i = 1; i <= m; i++)
+    {
+        current[0] = i;
+        size_t current_min = i;
+        for (size_t j = 1; j <= n; j++)
+        {
+            size_t cost = a[i - 1] != b[j - 1];
+            size_t best = previous[j - 1] + cost;
+            if (previous[j] + 1 < best)
+                best = previous[j] + 1;
+            if (current[j - 1] + 1 < best)
+                best = current[j - 1] + 1;
+            if (i > 1 && j > 1 && a[i - 1] == b[j - 2] && a[i - 2] == b[j - 1] && before[j - 2] + 1 < best)
+                best = before[j - 2] + 1;
+            current[j] = best;
+            if (best < current_min)
+                current_min = best;
+        }
+        // a row is never below both of the two rows before it
+        if (current_min >= bound && previous_min >= bound)
+            return bound;
+        previous_min = current_min;
+        size_t *oldest = before;
+        before = previous;
+        previous = current;
+        current = oldest;
+    }
+    return previous[n];
+}
+
+/**
+ * Picks the registered long name closest to an unknown one: the only name it
+ * is a prefix of, else the first name in sorted order within a third of its
+ * length in edits.
+ *
+ * @return The index of the argument, or -1 if none is close.
+ */
+int myargs_suggest(const ArgumentParser *parser, const char *name, size_t length)
+{
+    int prefix = myargs_find_prefix(parser, name, length);
+    if (prefix >= 0)
+        return prefix;
+
+    int best = -1;
+    size_t best_distance = (length + 2) / 3 + 1;
+    for (int i = 0; i < parser->sorted_count; i++)
+    {
+        const char *candidate = parser->arguments[parser->sorted[i]].name;
+        size_t distance = myargs_distance(name, length, candidate, strlen(candidate), best_distance);
+        if (distance < best_distance)
+        {
+            best = parser->sorted[i];
+            best_distance = distance;
+        }
+    }
+    return best;
+}
+
+/**
+ * Resolves a long option that is not a registered name: an unambiguous
+ * abbreviation when allow_abbrev is set, otherwise an error naming the
+ * candidates or the closest name.
+ *
+ * @return The index of the argument, or -1 after reporting the error.
+ */
+int myargs_resolve_long(const ArgumentParser *parser, ArgumentResult *result, const char *name, size_t length)
+{
+    int j = parser->allow_abbrev ? myargs_find_prefix(parser, name, length) : -1;
+    if (j >= 0)
+        return j;
+
+    if (j == -2)
+    {
+        // the candidates are listed into a fixed buffer, truncated if need be
+        char candidates[MYARGS_ERROR_TEXT / 2];
+        candidates[0] = '\0';
+        size_t used = 0;
+        int first = myargs_lower_bound(parser, name, length);
+        for (int i = first; i < parser->sorted_count && used < sizeof(candidates); i++)
+        {
+            const char *candidate = parser->arguments[parser->sorted[i]].name;
+            if (strncmp(candidate, name, length) != 0)
+                break;
+            if (i - first == 8)
+            {
+                used += (size_t)snprintf(candidates + used, sizeof(candidates) - used, ", ...");
+                break;
+            }
+            used += (size_t)snprintf(candidates + used, sizeof(candidates) - used, "%s--%s", i == first ? " " : ", ", candidate);
+        }
+        myargs_error(result, ARGUMENT_AMBIGUOUS, name, length, "Ambiguous option: --%.*s could match%s", (int)length, name, candidates);
+        return -1;
+    }
+
+    int suggestion = myargs_suggest(parser, name, length);
+    if (suggestion >= 0)
+        myargs_error(result, ARGUMENT_UNKNOWN, name, length, "Unknown option: --%.*s (did you mean --%s?)", (int)length, name, parser->arguments[suggestion].name);
+    else
+        myargs_error(result, ARGUMENT_UNKNOWN, name, length, "Unknown option: --%.*s", (int)length, name);
+    return -1;
+}
+
+/**
+ * Inserts subcommand i into the command index, growing it so that it is
+ * never more than half full. The first subcommand registered under a name wins.
+ */
+void myargs_index_command(ArgumentParser *parser, int i)
+{
+    ArgumentCommand *command = &parser->commands[i];
+    command->hash = myargs_hash(command->name, strlen(command->name));
+
+    if ((i + 1) * 2 > parser->command_index_size)
+    {
+        int size = parser->command_index_size ? parser->command_index_size * 2 : 16;
+        myargs_free(parser, parser->command_index);
+        parser->command_index = (int *)myargs_alloc(parser, sizeof(int) * size);
+        if (!parser->command_index)
+        {
+            fprintf(stderr, "Out of memory\n");
+            exit(EXIT_FAILURE);
+        }
+        memset(parser->command_index, -1, sizeof(int) * size);
+        parser->command_index_size = size;
+
+        for (int j = 0; j < i; j++)
+        {
+            unsigned int slot = parser->commands[j].hash & (size - 1);
+            while (parser->command_index[slot] >= 0)
+                slot = (slot + 1) & (size - 1);
+            parser->command_index[slot] = j;
+        }
+    }
+
+    unsigned int mask = parser->command_index_size - 1;
+    unsigned int slot = command->hash & mask;
+    while (parser->command_index[slot] >= 0)
+    {
+        ArgumentCommand *other = &parser->commands[parser->command_index[slot]];
+        if (other->hash == command->hash && strcmp(other->name, command->name) == 0)
+            return;
+        slot = (slot + 1) & mask;
+    }
+    parser->command_index[slot] = i;
+}
+
+/**
+ * Looks up a subcommand by name.
+ *
+ * @return The index of the subcommand, or -1 if there is none.
+ */
+int myargs_find_command(const ArgumentParser *parser, const char *name, size_t length)
+{
+    if (parser->command_index_size == 0)
+        return -1;
+
+    MYARGS_COUNT(lookups, 1);
+    unsigned int hash = myargs_hash(name, length);
+    unsigned int mask = parser->command_index_size - 1;
+    for (unsigned int slot = hash & mask; parser->command_index[slot] >= 0; slot = (slot + 1) & mask)
+    {
+        const ArgumentCommand *command = &parser->commands[parser->command_index[slot]];
+        if (command->hash == hash && strncmp(command->name, name, length) == 0 && command->name[length] == '\0')
+            return parser->command_index[slot];
+    }
+    return -1;
+}
+
+#if defined(MYARGS_SSE2) || defined(MYARGS_NEON)
+/**
+ * Returns the index of the lowest set bit of a non-zero mask.
+ */
+unsigned int myargs_ctz(unsigned long long mask)
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long index;
+    _BitScanForward64(&index, mask);
+    return (unsigned int)index;
+#else
+    return (unsigned int)__builtin_ctzll(mask);
+#endif
+}
+#endif // MYARGS_SSE2 || MYARGS_NEON
+
+/**
+ * Finds the length of a string and its first '=' in one pass. The SIMD
+ * versions compare 16 bytes per step using aligned loads, which never cross
+ * into the next page, so reading past the terminator is always safe.
+ *
+ * @return The length of str; *equals is set to the first '=', or NULL.
+ */
+#if defined(MYARGS_SSE2)
+MYARGS_NO_SANITIZE size_t myargs_scan(const char *str, const char **equals)
+{
+    const char *block = (const char *)((uintptr_t)str & ~(uintptr_t)15);
+    unsigned int skip = (unsigned int)(str - block);
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i eq = _mm_set1_epi8('=');
+
+    *equals = NULL;
+    for (;; block += 16, skip = 0)
+    {
+        __m128i chunk = _mm_load_si128((const __m128i *)block);
+        unsigned int nul = ((unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, zero)) >> skip) << skip;
+        unsigned int hit = ((unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, eq)) >> skip) << skip;
+        if (nul)
+            hit &= (nul & -nul) - 1;
+        if (hit && !*equals)
+            *equals = block + myargs_ctz(hit);
+        if (nul)
+            return (size_t)(block + myargs_ctz(nul) - str);
+    }
+}
+#elif defined(MYARGS_NEON)
+MYARGS_NO_SANITIZE size_t myargs_scan(const char *str, const char **equals)
+{
+    const char *block = (const char *)((uintptr_t)str & ~(uintptr_t)15);
+    unsigned int skip = (unsigned int)(str - block) * 4;
+
+    *equals = NULL;
+    for (;; block += 16, skip = 0)
+    {
+        // narrowing the comparison leaves 4 bits per byte in a 64-bit mask
+        uint8x16_t chunk = vld1q_u8((const uint8_t *)block);
+        uint64_t nul = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(vceqq_u8(chunk, vdupq_n_u8(0))), 4)), 0);
+        uint64_t hit = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(vceqq_u8(chunk, vdupq_n_u8('='))), 4)), 0);
+        nul = (nul >> skip) << skip;
+        hit = (hit >> skip) << skip;
+        if (nul)
+            hit &= (nul & -nul) - 1;
+        if (hit && !*equals)
+            *equals = block + myargs_ctz(hit) / 4;
+        if (nul)
+            return (size_t)(block + myargs_ctz(nul) / 4 - str);
+    }
+}
+#else
+size_t myargs_scan(const char *str, const char **equals)
+{
+    const char *pos = str;
+    *equals = NULL;
+    for (; *pos; pos++)
+    {
+        if (*pos == '=' && !*equals)
+            *equals = pos;
+    }
+    return (size_t)(pos - str);
+}
+#endif // MYARGS_SSE2
+
+/**
+ * Classifies a token and splits it into name and value.
+ */
+void myargs_classify(const char *token, ArgumentToken *out)
+{
+    const char *equals;
+    size_t length = myargs_scan(token, &equals);
+
+    size_t dashes = token[0] == '-' ? token[1] == '-' ? 2 : 1 : 0;
+    out->kind = dashes == 2 ? length == 2 ? TOKEN_TERMINATOR : TOKEN_LONG : dashes == 1 ? TOKEN_SHORT : TOKEN_BARE;
+    out->name = token + dashes;
+    out->length = (equals ? (size_t)(equals - token) : length) - dashes;
+    out->value = equals ? equals + 1 : NULL;
+    out->value_length = equals ? length - (size_t)(equals + 1 - token) : 0;
+}
+
+/**
+ * Whether an argument takes more than one value (any nargs other than 1).
+ */
+bool myargs_is_multi(const Argument *argument)
+{
+    return argument->type == ARG && argument->count != 1;
+}
+
+/**
+ * Returns the Type of argument i, with MYARGS_KIND_MULTI if it takes several
+ * values, from the dense kinds of a frozen parser when there are any.
+ */
+uint8_t myargs_kind(const ArgumentParser *parser, int i)
+{
+    if (parser->kinds)
+        return parser->kinds[i];
+    const Argument *argument = &parser->arguments[i];
+    return (uint8_t)(argument->type | (myargs_is_multi(argument) ? MYARGS_KIND_MULTI : 0));
+}
+
+/**
+ * Duplicates the first length bytes of a string into the result's arena.
+ */
+char *myargs_result_strndup(ArgumentResult *result, const char *str, size_t length)
+{
+    char *copy = (char *)myargs_result_alloc(result, length + 1);
+    if (copy)
+    {
+        memcpy(copy, str, length);
+        copy[length] = '\0';
+    }
+    return copy;
+}
+
+/**
+ * Unmaps or frees the response files read by the current parse.
+ */
+void myargs_release_files(ArgumentResult *result)
+{
+    for (ArgumentFile *file = result->files; file; file = file->next)
+    {
+#ifdef MYARGS_MMAP
+        if (file->mapped)
+            munmap(file->data, file->size);
+#else
+        myargs_heap_free(file->data);
+#endif // MYARGS_MMAP
+    }
+    result->files = NULL;
+}
+
+/**
+ * Maps a response file and pushes it onto the cursor, so its tokens are read
+ * before the rest of the command line. The mapping is private, which lets the
+ * tokenizer terminate and unquote tokens in place; it stays alive until the
+ * result is reset or freed because values may point into it.
+ */
+void myargs_open_response_file(ArgumentResult *result, ArgumentCursor *cursor, const char *path)
+{
+    if (cursor->depth == MYARGS_RESPONSE_DEPTH)
+    {
+        myargs_error(result, ARGUMENT_RESPONSE_FILE, path, strlen(path), "Response files nested too deeply: %s", path);
+        return;
+    }
+
+#ifdef MYARGS_MMAP
+    // nothing is allocated until the file is known to be readable
+    int fd = open(path, O_RDONLY);
+    struct stat info;
+    if (fd < 0 || fstat(fd, &info) != 0)
+    {
+        if (fd >= 0)
+            close(fd);
+        myargs_error(result, ARGUMENT_RESPONSE_FILE, path, strlen(path), "Cannot read response file: %s", path);
+        return;
+    }
+    void *data = NULL;
+    if (info.st_size > 0 && (data = mmap(NULL, (size_t)info.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0)) == MAP_FAILED)
+    {
+        close(fd);
+        myargs_error(result, ARGUMENT_RESPONSE_FILE, path, strlen(path), "Cannot read response file: %s", path);
+        return;
+    }
+#else
+    // a stream that cannot be sized, such as a pipe, cannot be read either
+    FILE *stream = fopen(path, "rb");
+    long length = -1;
+    if (!stream || fseek(stream, 0, SEEK_END) != 0 || (length = ftell(stream)) < 0)
+    {
+        if (stream)
+            fclose(stream);
+        myargs_error(result, ARGUMENT_RESPONSE_FILE, path, strlen(path), "Cannot read response file: %s", path);
+        return;
+    }
+#endif // MYARGS_MMAP
+
+    ArgumentFile *file = (ArgumentFile *)myargs_result_alloc(result, sizeof(ArgumentFile));
+    if (!file)
+    {
+#ifdef MYARGS_MMAP
+        if (data)
+            munmap(data, (size_t)info.st_size);
+        close(fd);
+#else
+        fclose(stream);
+#endif // MYARGS_MMAP
+        myargs_error(result, ARGUMENT_ERROR, path, strlen(path), "Out of memory reading response file: %s", path);
+        return;
+    }
+    file->data = NULL;
+    file->size = 0;
+    file->mapped = false;
+    bool terminated = true;
+
+#ifdef MYARGS_MMAP
+    file->size = (size_t)info.st_size;
+    if (file->size > 0)
+    {
+#ifdef POSIX_MADV_SEQUENTIAL
+        posix_madvise(data, file->size, POSIX_MADV_SEQUENTIAL);
+#endif // POSIX_MADV_SEQUENTIAL
+        file->data = (char *)data;
+        file->mapped = true;
+        // the zero-filled tail of the last page terminates the last token,
+        // unless the file fills that page exactly
+        terminated = file->size % (size_t)sysconf(_SC_PAGESIZE) != 0;
+    }
+    close(fd);
+#else
+    file->size = (size_t)length;
+    file->data = (char *)myargs_heap_alloc(file->size + 1);
+    if (!file->data)
+    {
+        fclose(stream);
+        myargs_error(result, ARGUMENT_ERROR, path, strlen(path), "Out of memory reading response file: %s", path);
+        return;
+    }
+    rewind(stream);
+    file->size = fread(file->data, 1, file->size, stream);
+    file->data[file->size] = '\0';
+    fclose(stream);
+#endif // MYARGS_MMAP
+
+    file->next = result->files;
+    result->files = file;
+
+    cursor->frames[cursor->depth].file = file;
+    cursor->frames[cursor->depth].pos = file->data;
+    cursor->frames[cursor->depth].end = file->data + file->size;
+    cursor->frames[cursor->depth].terminated = terminated;
+    cursor->depth++;
+}
+
+/**
+ * Reads the next whitespace-separated token of a response file, honouring
+ * single and double quotes and backslash escapes. The token is unquoted and
+ * NUL terminated in place, so it is a view into the mapping.
+ *
+ * @return The token, or NULL at the end of the file.
+ */
+char *myargs_file_token(ArgumentResult *result, ArgumentFrame *frame)
+{
+    char *pos = frame->pos;
+    char *end = frame->end;
+    while (pos < end && isspace((unsigned char)*pos))
+        pos++;
+    if (pos == end)
+    {
+        frame->pos = pos;
+        return NULL;
+    }
+
+    char *token = pos;
+    char *out = pos;
+    char quote = '\0';
+    while (pos < end && (quote || !isspace((unsigned char)*pos)))
+    {
+        char c = *pos++;
+        if (quote && c == quote)
+            quote = '\0';
+        else if (!quote && (c == '"' || c == '\''))
+            quote = c;
+        else if (c == '\\' && quote != '\'' && pos < end)
+            *out++ = *pos++;
+        else
+            *out++ = c;
+    }
+    frame->pos = pos < end ? pos + 1 : pos;
+
+    if (out < end)
+        *out = '\0';
+    else if (!frame->terminated)
+        return myargs_result_strndup(result, token, (size_t)(out - token));
+    return token;
+}
+
+/**
+ * Returns the next command-line token, expanding response files on the way.
+ *
+ * @return The token, or NULL when the command line is exhausted.
+ */
+const char *myargs_next(const ArgumentParser *parser, ArgumentResult *result, ArgumentCursor *cursor)
+{
+    if (cursor->peeked)
+    {
+        const char *token = cursor->peeked;
+        cursor->peeked = NULL;
+        return token;
+    }
+
+    for (;;)
+    {
+        const char *token;
+        if (cursor->depth > 0)
+        {
+            token = myargs_file_token(result, &cursor->frames[cursor->depth - 1]);
+            if (!token)
+            {
+                cursor->depth--;
+                continue;
+            }
+        }
+        else if (cursor->index < cursor->argc)
+        {
+            token = cursor->argv[cursor->index++];
+        }
+        else
+        {
+            return NULL;
+        }
+
+        if (parser->fromfile_prefix_char && token[0] == parser->fromfile_prefix_char && token[1] != '\0')
+        {
+            myargs_open_response_file(result, cursor, token + 1);
+            continue;
+        }
+        return token;
+    }
+}
+
+/**
+ * Returns the next command-line token without consuming it.
+ */
+const char *myargs_peek(const ArgumentParser *parser, ArgumentResult *result, ArgumentCursor *cursor)
+{
+    if (!cursor->peeked)
+        cursor->peeked = myargs_next(parser, result, cursor);
+    return cursor->peeked;
+}
+
+/**
+ * Appends a value to the value pool, growing it geometrically. Spans already
+ * handed out to arguments are moved along with the pool.
+ */
+void myargs_push_value(const ArgumentParser *parser, ArgumentResult *result, const char *value)
+{
+    if (result->value_pool_used == result->value_pool_size)
+    {
+        char **old = result->value_pool;
+        int size = result->value_pool_size ? result->value_pool_size * 2 : 16;
+        char **pool = (char **)myargs_result_alloc(result, sizeof(char *) * size);
+        if (!pool)
+        {
+            myargs_error(result, ARGUMENT_ERROR, "", 0, "Out of memory storing a value");
+            return;
+        }
+        if (old)
+            memcpy(pool, old, sizeof(char *) * result->value_pool_used);
+        for (int i = 0; i < parser->count; i++)
+        {
+            ArgumentValue *slot = &result->values[i];
+            if (slot->values >= old && slot->values < old + result->value_pool_used)
+                slot->values = pool + (slot->values - old);
+        }
+        result->value_pool = pool;
+        result->value_pool_size = size;
+    }
+    result->value_pool[result->value_pool_used++] = (char *)value;
+}
+
+/**
+ * Reads the values of multi-value argument j that follow the ones already in
+ * the value pool from start: the following tokens that are not options, up to
+ * the argument's count. When a stream runs out of tokens first, the argument
+ * is left open and the next fed token continues it.
+ */
+void myargs_collect_values(const ArgumentParser *parser, ArgumentResult *result, int j, int start, ArgumentCursor *cursor)
+{
+    const Argument *argument = &parser->arguments[j];
+    ArgumentValue *slot = &result->values[j];
+    int max = argument->count > 0 ? argument->count : argument->count == NARGS_OPTIONAL ? 1 : INT_MAX;
+    int min = argument->count > 0 ? argument->count : argument->count == NARGS_ONE_OR_MORE ? 1 : 0;
+
+    int n = result->value_pool_used - start;
+    const char *next;
+    while (n < max && (next = myargs_peek(parser, result, cursor)) != NULL && (next[0] != '-' || next[1] == '\0'))
+    {
+        myargs_push_value(parser, result, myargs_next(parser, result, cursor));
+        n++;
+    }
+
+    if (n < max && cursor->stream && !cursor->peeked)
+    {
+        result->open_argument = j;
+        result->open_start = start;
+    }
+    else if (n < min)
+    {
+        myargs_error(result, ARGUMENT_TOO_FEW, argument->name, strlen(argument->name), "Expected %s%d values for argument: %s", argument->count > 0 ? "" : "at least ", min, argument->name);
+    }
+
+    slot->values = n ? result->value_pool + start : NULL;
+    slot->nvalues = n;
+    slot->value = n ? slot->values[0] : NULL;
+    slot->length = n ? strlen(slot->values[0]) : 0;
+    slot->pending = n > 0;
+}
+
+/**
+ * Collects the values of multi-value argument j into the value pool: the
+ * inline value after '=' if any, then the following tokens that are not
+ * options, up to the argument's count.
+ */
+void myargs_take_values(const ArgumentParser *parser, ArgumentResult *result, int j, const char *value, ArgumentCursor *cursor)
+{
+    int start = result->value_pool_used;
+    if (value)
+        myargs_push_value(parser, result, value);
+    myargs_collect_values(parser, result, j, start, cursor);
+}
+
+/**
+ * Stores a value of length bytes parsed from argv into argument i. Flags are set to "true";
+ * other arguments either copy the value into the result's arena or, with
+ * zero_copy, point at it. A lazy parse also points at it, leaving the copy to
+ * myargs_finish_value. A stored value is marked pending, so a getter called
+ * before the parse is finished, as with parser_feed, converts it first.
+ */
+void myargs_set_value(const ArgumentParser *parser, ArgumentResult *result, int i, const char *value, size_t length)
+{
+    ArgumentValue *slot = &result->values[i];
+    if (myargs_kind(parser, i) == FLAG)
+    {
+        slot->value = (char *)"true";
+        slot->length = 4;
+        slot->pending = true;
+        return;
+    }
+
+    slot->pending = value != NULL;
+    slot->length = value ? length : 0;
+    if (!value)
+        slot->value = NULL;
+    else if (parser->zero_copy || parser->lazy)
+        slot->value = (char *)value;
+    else
+        slot->value = myargs_result_strndup(result, value, slot->length);
+}
+
+/**
+ * Applies a bundle of short options in one pass, dispatching each symbol
+ * through the symbol table. Flags are set as they are met. Without '=', the
+ * first option that takes a value ends the bundle and takes the rest of the
+ * token, so -c5 and -vc5 give c the value 5. With '=', as in -vs=hello, the
+ * value goes only to the last option of the bundle that takes one.
+ */
+void myargs_take_bundle(const ArgumentParser *parser, ArgumentResult *result, const ArgumentToken *info, ArgumentCursor *cursor)
+{
+    int taker = -1;
+    for (size_t j = 0; j < info->length; j++)
+    {
+        int k = myargs_find_sym(parser, info->name[j]);
+        if (k < 0)
+            continue;
+
+        uint8_t kind = myargs_kind(parser, k);
+        if (kind == FLAG)
+        {
+            myargs_set_value(parser, result, k, NULL, 0);
+        }
+        else if (kind != ARG && !info->value)
+        {
+            const char *rest = j + 1 < info->length ? info->name + j + 1 : NULL;
+            if (kind & MYARGS_KIND_MULTI)
+                myargs_take_values(parser, result, k, rest, cursor);
+            else
+                myargs_set_value(parser, result, k, rest, info->length - j - 1);
+            return;
+        }
+        else if (kind != ARG)
+        {
+            taker = k;
+        }
+    }
+
+    if (taker >= 0 && (myargs_kind(parser, taker) & MYARGS_KIND_MULTI))
+        myargs_take_values(parser, result, taker, info->value, cursor);
+    else if (taker >= 0)
+        myargs_set_value(parser, result, taker, info->value, info->value_length);
+}
+
+/**
+ * Converts the string value of an argument according to its value_type.
+ *
+ * @return false if the value does not convert.
+ */
+bool myargs_convert(const Argument *argument, ArgumentValue *slot)
+{
+    const char *value = slot->value;
+    char *end = NULL;
+
+    slot->integer = 0;
+    if (!value || argument->value_type == VALUE_STRING)
+        return true;
+
+    errno = 0;
+    switch (argument->value_type)
+    {
+    case VALUE_INT:
+        slot->integer = strtoll(value, &end, 0);
+        break;
+    case VALUE_DOUBLE:
+        slot->real = strtod(value, &end);
+        break;
+    case VALUE_SIZE:
+    {
+        unsigned long long size = strtoull(value, &end, 10);
+        int shift = 0;
+        switch (*end)
+        {
+        case 'k': case 'K': shift = 10; break;
+        case 'm': case 'M': shift = 20; break;
+        case 'g': case 'G': shift = 30; break;
+        case 't': case 'T': shift = 40; break;
+        }
+        if (shift)
+        {
+            end++;
+            if (*end == 'i')
+                end++;
+            if (size > (~0ull >> 1) >> shift)
+                errno = ERANGE;
+        }
+        if (*end == 'B')
+            end++;
+        if (*value == '-')
+            return false;
+        slot->integer = (long long)(size << shift);
+        break;
+    }
+    case VALUE_BOOL:
+        if (strcmp(value, "true") == 0 || strcmp(value, "yes") == 0 || strcmp(value, "on") == 0 || strcmp(value, "1") == 0)
+            slot->integer = 1;
+        else if (strcmp(value, "false") != 0 && strcmp(value, "no") != 0 && strcmp(value, "off") != 0 && strcmp(value, "0") != 0)
+            return false;
+        return true;
+    case VALUE_ENUM:
+    {
+        const char *choice = argument->choices;
+        size_t length = strlen(value);
+        for (long long index = 0; choice && *choice; index++)
+        {
+            const char *next = strchr(choice, ',');
+            size_t choice_length = next ? (size_t)(next - choice) : strlen(choice);
+            if (choice_length == length && strncmp(choice, value, length) == 0)
+            {
+                slot->integer = index;
+                return true;
+            }
+            choice = next ? next + 1 : NULL;
+        }
+        return false;
+    }
+    default:
+        return true;
+    }
+    return end != value && *end == '\0' && errno == 0;
+}
+
+ArgumentHandle add_arg(ArgumentParser *parser, char sym, const char *name, int required, int nargs, const char *default_value, const char *help)
+{
+    ArgumentPhase phase;
+    myargs_phase_begin(&phase);
+    myargs_grow_arguments(parser);
+    parser->arguments[parser->count].name = myargs_strdup(parser, name);
+    parser->arguments[parser->count].required = required;
+    parser->arguments[parser->count].def_val = myargs_strdup(parser, default_value);
+    parser->arguments[parser->count].value_type = VALUE_STRING;
+    parser->arguments[parser->count].choices = NULL;
+    parser->arguments[parser->count].env_value = NULL;
+    parser->arguments[parser->count].config_value = NULL;
+    parser->arguments[parser->count].sym = sym ? sym : '0';
+    parser->arguments[parser->count].help = myargs_strdup(parser, help);
+    parser->arguments[parser->count].type = ARG;
+    parser->arguments[parser->count].count = nargs;
+    myargs_index_argument(parser, parser->count, sym);
+    myargs_phase_end(&phase, PHASE_REGISTER, "add_arg", parser, name, NULL);
+    return parser->count++;
+}
+
+ArgumentHandle add_kwarg(ArgumentParser *parser, char sym, const char *name, int required, const char *default_value, const char *help)
+{
+    ArgumentPhase phase;
+    myargs_phase_begin(&phase);
+    myargs_grow_arguments(parser);
+    parser->arguments[parser->count].name = myargs_strdup(parser, name);
+    parser->arguments[parser->count].required = required;
+    parser->arguments[parser->count].def_val = myargs_strdup(parser, default_value);
+    parser->arguments[parser->count].value_type = VALUE_STRING;
+    parser->arguments[parser->count].choices = NULL;
+    parser->arguments[parser->count].env_value = NULL;
+    parser->arguments[parser->count].config_value = NULL;
+    parser->arguments[parser->count].sym = sym ? sym : '0';
+    parser->arguments[parser->count].help = myargs_strdup(parser, help);
+    parser->arguments[parser->count].type = KWARG;
+    parser->arguments[parser->count].count = 1;
+    myargs_index_argument(parser, parser->count, sym);
+    myargs_phase_end(&phase, PHASE_REGISTER, "add_kwarg", parser, name, NULL);
+    return parser->count++;
+}
+
+ArgumentHandle add_flag(ArgumentParser *parser, char sym, const char *name, const char *help)
+{
+    ArgumentPhase phase;
+    myargs_phase_begin(&phase);
+    myargs_grow_arguments(parser);
+    parser->arguments[parser->count].name = myargs_strdup(parser, name);
+    parser->arguments[parser->count].required = 0;
+    parser->arguments[parser->count].def_val = NULL;
+    parser->arguments[parser->count].value_type = VALUE_STRING;
+    parser->arguments[parser->count].choices = NULL;
+    parser->arguments[parser->count].env_value = NULL;
+    parser->arguments[parser->count].config_value = NULL;
+    parser->arguments[parser->count].sym = sym ? sym : '0';
+    parser->arguments[parser->count].help = myargs_strdup(parser, help);
+    parser->arguments[parser->count].type = FLAG;
+    parser->arguments[parser->count].count = 0;
+    myargs_index_argument(parser, parser->count, sym);
+    myargs_phase_end(&phase, PHASE_REGISTER, "add_flag", parser, name, NULL);
+    return parser->count++;
+}
+
+int add_command(ArgumentParser *parser, const char *name, const char *help, ArgumentCommandBuilder build, void *data)
+{
+    myargs_check_mutable(parser, "add a subcommand");
+    ArgumentPhase phase;
+    myargs_phase_begin(&phase);
+    if (parser->command_count == parser->command_capacity)
+    {
+        int capacity = parser->command_capacity ? parser->command_capacity * 2 : 8;
+        parser->commands = (ArgumentCommand *)myargs_realloc(parser, parser->commands, sizeof(ArgumentCommand) * parser->command_capacity, sizeof(ArgumentCommand) * capacity);
+        if (!parser->commands)
+        {
+            fprintf(stderr, "Out of memory\n");
+            exit(EXIT_FAILURE);
+        }
+        parser->command_capacity = capacity;
+    }
+    myargs_invalidate_help(parser);
+
+    ArgumentCommand *command = &parser->commands[parser->command_count];
+    command->name = myargs_strdup(parser, name);
+    command->help = myargs_strdup(parser, help);
+    command->build = build;
+    command->data = data;
+    command->parser = NULL;
+    myargs_index_command(parser, parser->command_count);
+    myargs_phase_end(&phase, PHASE_REGISTER, "add_command", parser, name, NULL);
+    return parser->command_count++;
+}
+
+int get_command(const ArgumentParser *parser)
+{
+    return parser->result.command;
+}
+
+ArgumentParser *get_command_parser(ArgumentParser *parser, int command)
+{
+    ArgumentCommand *entry = &parser->commands[command];
+    if (!entry->parser)
+    {
+        myargs_check_mutable(parser, "build a subcommand");
+        ArgumentParser *sub = (ArgumentParser *)myargs_alloc(parser, sizeof(ArgumentParser));
+        if (!sub)
+        {
+            fprintf(stderr, "Out of memory\n");
+            exit(EXIT_FAILURE);
+        }
+        init_parser(sub, entry->name, NULL, entry->help, NULL);
+        sub->zero_copy = parser->zero_copy;
+        sub->lazy = parser->lazy;
+        sub->fromfile_prefix_char = parser->fromfile_prefix_char;
+        sub->exit_on_error = parser->exit_on_error;
+        sub->color = parser->color;
+        sub->help_width = parser->help_width;
+        if (entry->build)
+            entry->build(sub, entry->data);
+        entry->parser = sub;
+    }
+    return entry->parser;
+}
+
+int get_result_command(const ArgumentResult *result, int *offset)
+{
+    if (offset)
+        *offset = result->command >= 0 ? result->command_offset : 0;
+    return result->command;
+}
+
+/**
+ * Returns the field the value of an argument not given on the command line
+ * comes from: its environment variable, else its config file entry, else
+ * its default.
+ */
+char *const *myargs_fallback(const Argument *argument)
+{
+    if (argument->env_value)
+        return &argument->env_value;
+    if (argument->config_value)
+        return &argument->config_value;
+    return &argument->def_val;
+}
+
+/**
+ * Completes the value of argument i once its tokens have been read: applies
+ * the fallback when it was not given, copies a lazily kept view out of argv
+ * and converts it to the argument's value_type.
+ */
+void myargs_finish_value(const ArgumentParser *parser, ArgumentResult *result, int i)
+{
+    const Argument *argument = &parser->arguments[i];
+    ArgumentValue *slot = &result->values[i];
+    slot->pending = false;
+    char *const *fallback = myargs_fallback(argument);
+    if (!slot->value)
+    {
+        slot->value = *fallback;
+        slot->length = *fallback ? strlen(*fallback) : 0;
+        if (myargs_is_multi(argument) && *fallback)
+        {
+            slot->values = (char **)fallback;
+            slot->nvalues = 1;
+        }
+    }
+    else if (parser->lazy && !parser->zero_copy && argument->type != FLAG && !myargs_is_multi(argument) && slot->value != *fallback)
+    {
+        slot->value = myargs_result_strndup(result, slot->value, slot->length);
+    }
+
+    if (!myargs_convert(argument, slot))
+        myargs_error(result, ARGUMENT_INVALID, argument->name, strlen(argument->name), "Invalid value for argument %s: %s", argument->name, slot->value);
+}
+
+/**
+ * Returns the parsed state of argument i, finishing it first if a lazy parse
+ * deferred it. The work is done once and memoized in the result.
+ */
+ArgumentValue *myargs_value(const ArgumentResult *result, int i)
+{
+    ArgumentValue *slot = &result->values[i];
+    if (slot->pending)
+        myargs_finish_value(result->parser, (ArgumentResult *)result, i);
+    return slot;
+}
+
+/**
+ * Makes sure a result has a value slot for every argument of parser.
+ */
+void myargs_reserve_result(const ArgumentParser *parser, ArgumentResult *result)
+{
+    if (result->capacity >= parser->count)
+        return;
+
+    // arguments were added after init_result
+    ArgumentValue *values = (ArgumentValue *)(result->owns_values ? myargs_heap_realloc(result->values, sizeof(ArgumentValue) * parser->count) : myargs_heap_alloc(sizeof(ArgumentValue) * parser->count));
+    if (!values)
+    {
+        fprintf(stderr, "Out of memory\n");
+        exit(EXIT_FAILURE);
+    }
+    result->values = values;
+    result->capacity = parser->count;
+    result->owns_values = true;
+}
+
+/**
+ * Starts a parse of a new command line into result. The value pool is left
+ * as it is, so the spans of arguments an earlier parse gave stay valid; only
+ * reset_result starts it over.
+ */
+void myargs_begin(const ArgumentParser *parser, ArgumentResult *result)
+{
+    result->parser = parser;
+    result->command = -1;
+    result->open_argument = -1;
+}
+
+/**
+ * Applies one classified token to result. Returns false when the token names
+ * a subcommand, which takes the rest of the command line.
+ */
+bool myargs_apply(const ArgumentParser *parser, ArgumentResult *result, const ArgumentToken *info, ArgumentCursor *cursor)
+{
+    if (info->kind == TOKEN_LONG)
+    {
+        int j = myargs_find(parser, info->name, info->length);
+        if (j < 0 && (j = myargs_resolve_long(parser, result, info->name, info->length)) < 0)
+            return true;
+        if (myargs_kind(parser, j) & MYARGS_KIND_MULTI)
+            myargs_take_values(parser, result, j, info->value, cursor);
+        else
+            myargs_set_value(parser, result, j, info->value, info->value_length);
+    }
+
+    // for -o -i -s=hello, -ois=hello or -c5
+    else if (info->kind == TOKEN_SHORT)
+    {
+        myargs_take_bundle(parser, result, info, cursor);
+    }
+    else if (info->kind == TOKEN_BARE)
+    {
+        int j = myargs_find(parser, info->name, info->length);
+        if (j >= 0)
+        {
+            myargs_set_value(parser, result, j, info->value, info->value_length);
+        }
+        else if (!info->value && cursor->depth == 0 && (j = myargs_find_command(parser, info->name, info->length)) >= 0)
+        {
+            // the rest of argv belongs to the subcommand
+            result->command = j;
+            result->command_offset = cursor->index - 1;
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Applies the tokens of a cursor to result until they run out or one names
+ * a subcommand. Both parse_args and parser_feed dispatch through here.
+ */
+void myargs_dispatch(const ArgumentParser *parser, ArgumentResult *result, ArgumentCursor *cursor)
+{
+    const char *token;
+    ArgumentToken info;
+    if (!MYARGS_COUNTING)
+    {
+        while ((token = myargs_next(parser, result, cursor)) != NULL)
+        {
+            myargs_classify(token, &info);
+            if (!myargs_apply(parser, result, &info, cursor))
+                break;
+        }
+        return;
+    }
+
+    // while counting, reading a token is timed apart from applying it
+    while (true)
+    {
+        unsigned long long start = myargs_ticks();
+        if ((token = myargs_next(parser, result, cursor)) != NULL)
+            myargs_classify(token, &info);
+        unsigned long long classified = myargs_ticks();
+        myargs_stats.tokenize_time += (double)(classified - start) / 1e9;
+        if (!token)
+            break;
+        bool more = myargs_apply(parser, result, &info, cursor);
+        myargs_stats.lookup_time += (double)(myargs_ticks() - classified) / 1e9;
+        if (!more)
+            break;
+    }
+}
+
+/**
+ * Ends a parse once every token has been applied: checks the required
+ * arguments, then finishes each value now or, with lazy, on first read.
+ */
+void myargs_end(const ArgumentParser *parser, ArgumentResult *result)
+{
+    unsigned long long start = MYARGS_COUNTING ? myargs_ticks() : 0;
+    for (int i = 0; i < parser->count; i++)
+    {
+        // an environment variable or config entry counts as giving the argument
+        const Argument *argument = &parser->arguments[i];
+        if (argument->required && !result->values[i].value && !argument->env_value && !argument->config_value)
+            myargs_error(result, ARGUMENT_MISSING, argument->name, strlen(argument->name), "Missing required argument: %s", argument->name);
+        if (parser->lazy)
+            result->values[i].pending = true;
+        else
+            myargs_finish_value(parser, result, i);
+    }
+    if (start)
+        myargs_stats.defaults_time += (double)(myargs_ticks() - start) / 1e9;
+}
+
+/**
+ * Parses a command line against a parser's registered arguments, storing
+ * what it finds in result. The parser is only read, so any number of results
+ * can be filled from the same parser.
+ */
+void myargs_parse(const ArgumentParser *parser, ArgumentResult *result, int argc, const char *const argv[])
+{
+    ArgumentPhase phase;
+    myargs_phase_begin(&phase);
+    ArgumentCursor cursor;
+    cursor.argv = argv;
+    cursor.argc = argc;
+    cursor.index = 1;
+    cursor.depth = 0;
+    cursor.peeked = NULL;
+    cursor.stream = false;
+
+    myargs_begin(parser, result);
+    if (result->value_pool_size - result->value_pool_used < argc)
+    {
+        // without response files this is the only allocation the pool
+        // needs; spans of an earlier parse stay in the old pool, which the
+        // arena keeps until reset_result
+        // if this fails, myargs_push_value tries again and reports it
+        result->value_pool = (char **)myargs_result_alloc(result, sizeof(char *) * argc);
+        result->value_pool_size = result->value_pool ? argc : 0;
+        result->value_pool_used = 0;
+    }
+
+    myargs_dispatch(parser, result, &cursor);
+    myargs_end(parser, result);
+    if (phase.start)
+        myargs_phase_end(&phase, PHASE_PARSE, "parse_args", parser, NULL, ",\"tokens\":%d,\"tokenize_ns\":%llu,\"lookup_ns\":%llu,\"defaults_ns\":%llu,\"since_init_ns\":%llu", cursor.index - 1, myargs_nanoseconds(myargs_stats.tokenize_time - phase.stats.tokenize_time), myargs_nanoseconds(myargs_stats.lookup_time - phase.stats.lookup_time), myargs_nanoseconds(myargs_stats.defaults_time - phase.stats.defaults_time), phase.start - parser->started);
+}
+
+/**
+ * Gives an arena parser's own result the rest of the parser's current block,
+ * so a large enough caller buffer keeps parsing off the heap as well.
+ */
+void myargs_claim_arena(ArgumentParser *parser)
+{
+    if (parser->arena && !parser->result.arena)
+    {
+        size_t spare = (parser->arena->size - parser->arena->used) & ~(size_t)(MYARGS_ARENA_ALIGN - 1);
+        if (spare >= sizeof(ArgumentArena) + 2 * MYARGS_ARENA_ALIGN + 256)
+            parser->result.arena = myargs_arena_from_buffer(myargs_alloc(parser, spare), spare);
+    }
+}
+
+ArgumentStatus parse_args(ArgumentParser *parser, int argc, char *argv[])
+{
+    return parse_args_const(parser, argc, (const char *const *)argv);
+}
+
+ArgumentStatus parse_args_const(ArgumentParser *parser, int argc, const char *const argv[])
+{
+    myargs_check_mutable(parser, "run parse_args (use parse_args_into)");
+#ifdef MYARGS_PROFILING
+    size_t flag_length = sizeof(MYARGS_PROFILE_FLAG) - 1;
+    if (argc >= 2 && strncmp(argv[1], MYARGS_PROFILE_FLAG, flag_length) == 0 && (argv[1][flag_length] == '\0' || argv[1][flag_length] == '='))
+    {
+        const char *path = argv[1][flag_length] == '=' ? argv[1] + flag_length + 1 : NULL;
+        if (myargs_start_profile(path) != 0)
+            fprintf(stderr, "Cannot open profile file: %s\n", path);
+        // parsing from the flag drops it, since argv[0] is never read
+        return parse_args_const(parser, argc - 1, argv + 1);
+    }
+#endif // MYARGS_PROFILING
+    if (complete_args(parser, argc, argv))
+        exit(EXIT_SUCCESS);
+    myargs_claim_arena(parser);
+    myargs_clear_diagnostics(&parser->result);
+    myargs_parse(parser, &parser->result, argc, argv);
+
+    ArgumentStatus status = myargs_status(&parser->result);
+    if (parser->result.command >= 0)
+    {
+        int offset = parser->result.command_offset;
+        ArgumentStatus command_status = parse_args_const(get_command_parser(parser, parser->result.command), argc - offset, argv + offset);
+        if (status == ARGUMENT_OK)
+            status = command_status;
+    }
+    return status;
+}
+
+ArgumentStatus parse_args_into(const ArgumentParser *parser, ArgumentResult *result, int argc, const char *const argv[])
+{
+    myargs_reserve_result(parser, result);
+    reset_result(result);
+    myargs_parse(parser, result, argc, argv);
+    return myargs_status(result);
+}
+
+/**
+ * Applies one fed token to result. The token is copied into the result's
+ * arena first, since the caller's buffer may be reused for the next one, and
+ * a multi-value argument left open by the previous token takes it if it can.
+ */
+void myargs_feed(const ArgumentParser *parser, ArgumentResult *result, const char *token, size_t length)
+{
+    ArgumentPhase phase;
+    myargs_phase_begin(&phase);
+    if (!result->streaming)
+    {
+        myargs_begin(parser, result);
+        myargs_clear_diagnostics(result);
+        result->streaming = true;
+    }
+
+    // with a subcommand named, the rest of the stream is the subcommand's
+    if (result->command < 0)
+    {
+        const char *copy = myargs_result_strndup(result, token, length);
+        ArgumentCursor cursor;
+        cursor.argv = &copy;
+        cursor.argc = 1;
+        cursor.index = 0;
+        cursor.depth = 0;
+        cursor.peeked = NULL;
+        cursor.stream = true;
+
+        int open = result->open_argument;
+        result->open_argument = -1;
+        if (open >= 0)
+            myargs_collect_values(parser, result, open, result->open_start, &cursor);
+        myargs_dispatch(parser, result, &cursor);
+    }
+    myargs_phase_end(&phase, PHASE_PARSE, NULL, parser, NULL, NULL);
+}
+
+/**
+ * Ends a fed command line: closes an argument still taking values, which
+ * must then have enough of them, and finishes the parse.
+ */
+void myargs_finish_stream(const ArgumentParser *parser, ArgumentResult *result)
+{
+    ArgumentPhase phase;
+    myargs_phase_begin(&phase);
+    if (!result->streaming)
+    {
+        myargs_begin(parser, result);
+        myargs_clear_diagnostics(result);
+    }
+
+    if (result->open_argument >= 0)
+    {
+        ArgumentCursor cursor;
+        cursor.argv = NULL;
+        cursor.argc = 0;
+        cursor.index = 0;
+        cursor.depth = 0;
+        cursor.peeked = NULL;
+        cursor.stream = false;
+
+        int open = result->open_argument;
+        result->open_argument = -1;
+        myargs_collect_values(parser, result, open, result->open_start, &cursor);
+    }
+
+    result->streaming = false;
+    myargs_end(parser, result);
+    myargs_phase_end(&phase, PHASE_PARSE, NULL, parser, NULL, NULL);
+}
+
+ArgumentStatus parser_feed(ArgumentParser *parser, const char *token, size_t length)
+{
+    myargs_check_mutable(parser, "run parser_feed (use parser_feed_into)");
+    if (parser->result.streaming && parser->result.command >= 0)
+    {
+        ArgumentStatus status = parser_feed(get_command_parser(parser, parser->result.command), token, length);
+        return myargs_status(&parser->result) != ARGUMENT_OK ? myargs_status(&parser->result) : status;
+    }
+    if (!parser->result.streaming)
+        myargs_claim_arena(parser);
+    myargs_feed(parser, &parser->result, token, length);
+    return myargs_status(&parser->result);
+}
+
+ArgumentStatus parser_finish(ArgumentParser *parser)
+{
+    myargs_check_mutable(parser, "run parser_finish (use parser_finish_into)");
+    myargs_finish_stream(parser, &parser->result);
+    ArgumentStatus status = myargs_status(&parser->result);
+    if (parser->result.command >= 0)
+    {
+        ArgumentStatus command_status = parser_finish(get_command_parser(parser, parser->result.command));
+        if (status == ARGUMENT_OK)
+            status = command_status;
+    }
+    return status;
+}
+
+ArgumentStatus parser_feed_into(const ArgumentParser *parser, ArgumentResult *result, const char *token, size_t length)
+{
+    if (!result->streaming)
+    {
+        myargs_reserve_result(parser, result);
+        reset_result(result);
+    }
+    myargs_feed(parser, result, token, length);
+    return myargs_status(result);
+}
+
+ArgumentStatus parser_finish_into(const ArgumentParser *parser, ArgumentResult *result)
+{
+    if (!result->streaming)
+    {
+        myargs_reserve_result(parser, result);
+        reset_result(result);
+    }
+    myargs_finish_stream(parser, result);
+    return myargs_status(result);
+}
+
+const ArgumentError_t *get_result_errors(const ArgumentResult *result, int *count)
+{
+    *count = result->diagnostics.count;
+    return result->diagnostics.errors;
+}
+
+const ArgumentError_t *get_errors(const ArgumentParser *parser, int *count)
+{
+    return get_result_errors(&parser->result, count);
+}
+
+void init_result(ArgumentResult *result, const ArgumentParser *parser, void *buffer, size_t size)
+{
+    myargs_clear_result(result);
+    size_t values_size = sizeof(ArgumentValue) * (size_t)parser->count;
+    size_t offset = buffer ? (MYARGS_ARENA_ALIGN - (size_t)buffer % MYARGS_ARENA_ALIGN) % MYARGS_ARENA_ALIGN : 0;
+    values_size = (values_size + MYARGS_ARENA_ALIGN - 1) & ~(size_t)(MYARGS_ARENA_ALIGN - 1);
+
+    if (buffer && size >= offset + values_size)
+    {
+        result->values = (ArgumentValue *)((char *)buffer + offset);
+        result->arena = myargs_arena_from_buffer((char *)buffer + offset + values_size, size - offset - values_size);
+    }
+    else
+    {
+        result->values = (ArgumentValue *)myargs_heap_alloc(values_size ? values_size : sizeof(ArgumentValue));
+        result->owns_values = true;
+    }
+    result->capacity = parser->count;
+    memset(result->values, 0, sizeof(ArgumentValue) * (size_t)result->capacity);
+}
+
+/**
+ * Splits the hot fields of every argument into dense arrays and interns the
+ * names into one pool, all in a single block, so lookups and the parse loop
+ * touch no Argument records. The records' names are pointed into the pool and
+ * the separate copies released.
+ */
+void myargs_pack_schema(ArgumentParser *parser)
+{
+    size_t pool = 0;
+    for (int i = 0; i < parser->count; i++)
+        pool += strlen(parser->arguments[i].name) + 2;
+
+    size_t count = (size_t)parser->count;
+    char *block = (char *)myargs_alloc(parser, (sizeof(unsigned int) + sizeof(uint32_t) + 1) * count + pool + 1);
+    if (!block)
+    {
+        fprintf(stderr, "Out of memory\n");
+        exit(EXIT_FAILURE);
+    }
+    parser->hashes = (unsigned int *)block;
+    parser->name_offsets = (uint32_t *)(block + sizeof(unsigned int) * count);
+    parser->kinds = (uint8_t *)(block + (sizeof(unsigned int) + sizeof(uint32_t)) * count);
+    parser->names = (char *)(parser->kinds + count);
+
+    size_t used = 0;
+    for (int i = 0; i < parser->count; i++)
+    {
+        Argument *argument = &parser->arguments[i];
+        size_t length = strlen(argument->name);
+        parser->hashes[i] = argument->hash;
+        parser->kinds[i] = (uint8_t)(argument->type | (myargs_is_multi(argument) ? MYARGS_KIND_MULTI : 0));
+        parser->name_offsets[i] = (uint32_t)used;
+        parser->names[used] = (char)(length < 255 ? length : 255);
+        memcpy(parser->names + used + 1, argument->name, length + 1);
+        myargs_free(parser, argument->name);
+        argument->name = parser->names + used + 1;
+        used += length + 2;
+    }
+}
+
+const ArgumentParser *freeze_parser(ArgumentParser *parser)
+{
+    // lay out the help once now rather than on a worker thread later
+    format_help(parser, 1, 1, 1, 1, NULL);
+    // a worker thread must not build a subcommand either
+    for (int i = 0; i < parser->command_count; i++)
+        freeze_parser(get_command_parser(parser, i));
+    if (!parser->frozen && !parser->names)
+        myargs_pack_schema(parser);
+    parser->frozen = true;
+    return parser;
+}
+
+/**
+ * Appends a string to a snapshot being written, returning its offset, or 0
+ * for NULL. Only the offset is computed when data is NULL.
+ */
+uint32_t myargs_schema_string(char *data, size_t *used, const char *str)
+{
+    if (!str)
+        return 0;
+    size_t length = strlen(str) + 1;
+    uint32_t offset = (uint32_t)*used;
+    if (data)
+        memcpy(data + offset, str, length);
+    *used += length;
+    return offset;
+}
+
+size_t save_schema(const ArgumentParser *parser, void *buffer, size_t size)
+{
+    if (parser->command_count > 0)
+        return 0;
+
+    size_t tables = sizeof(ArgumentSchema) + sizeof(ArgumentSchemaEntry) * (size_t)parser->count + sizeof(int32_t) * (size_t)(parser->index_size + parser->sorted_count);
+    size_t total = tables;
+    for (int pass = 0; pass < 2; pass++)
+    {
+        // the first pass measures the strings, the second writes everything
+        char *data = pass ? (char *)buffer : NULL;
+        if (pass && (!buffer || size < total))
+            break;
+
+        size_t used = tables;
+        ArgumentSchema header;
+        memset(&header, 0, sizeof(header));
+        header.magic = MYARGS_SCHEMA_MAGIC;
+        header.version = MYARGS_SCHEMA_VERSION;
+        header.count = parser->count;
+        header.index_size = parser->index_size;
+        header.sorted_count = parser->sorted_count;
+        for (int k = 0; k < 256; k++)
+            header.syms[k] = parser->syms[k];
+        header.program = myargs_schema_string(data, &used, parser->program);
+        header.usage = myargs_schema_string(data, &used, parser->usage);
+        header.description = myargs_schema_string(data, &used, parser->description);
+        header.epilog = myargs_schema_string(data, &used, parser->epilog);
+        header.help_column = (uint32_t)parser->help_column;
+        header.help_columns = (uint32_t)parser->help_columns;
+        header.prefix_char = parser->prefix_char;
+        header.fromfile_prefix_char = parser->fromfile_prefix_char;
+        header.add_help = parser->add_help;
+        header.allow_abbrev = parser->allow_abbrev;
+        header.exit_on_error = parser->exit_on_error;
+        header.zero_copy = parser->zero_copy;
+        header.lazy = parser->lazy;
+
+        size_t offset = sizeof(ArgumentSchema);
+        for (int i = 0; i < parser->count; i++)
+        {
+            const Argument *argument = &parser->arguments[i];
+            ArgumentSchemaEntry entry;
+            memset(&entry, 0, sizeof(entry));
+            entry.name = myargs_schema_string(data, &used, argument->name);
+            entry.help = myargs_schema_string(data, &used, argument->help);
+            entry.def_val = myargs_schema_string(data, &used, argument->def_val);
+            entry.choices = myargs_schema_string(data, &used, argument->choices);
+            entry.hash = argument->hash;
+            entry.required = argument->required;
+            entry.count = argument->count;
+            entry.sym = argument->sym;
+            entry.type = (uint8_t)argument->type;
+            entry.value_type = (uint8_t)argument->value_type;
+            if (data)
+                memcpy(data + offset, &entry, sizeof(entry));
+            offset += sizeof(entry);
+        }
+
+        total = used;
+        header.size = (uint32_t)total;
+        if (data)
+        {
+            memcpy(data, &header, sizeof(header));
+            memcpy(data + offset, parser->index, sizeof(int32_t) * (size_t)parser->index_size);
+            offset += sizeof(int32_t) * (size_t)parser->index_size;
+            memcpy(data + offset, parser->sorted, sizeof(int32_t) * (size_t)parser->sorted_count);
+        }
+    }
+    return total;
+}
+
+/**
+ * Loads a schema snapshot as load_schema does, with extra bytes at the end of
+ * the parser's block, 8-byte aligned, returned through tail.
+ */
+int myargs_load_schema(ArgumentParser *parser, const void *snapshot, size_t size, size_t extra, void **tail)
+{
+    const char *data = (const char *)snapshot;
+    ArgumentSchema header;
+    if (size < sizeof(header))
+        return -1;
+    memcpy(&header, data, sizeof(header));
+    size_t tables = sizeof(ArgumentSchema) + sizeof(ArgumentSchemaEntry) * (size_t)header.count + sizeof(int32_t) * (size_t)(header.index_size + header.sorted_count);
+    if (header.magic != MYARGS_SCHEMA_MAGIC || header.version != MYARGS_SCHEMA_VERSION || header.size > size || header.count < 0 || header.index_size < 0 || header.sorted_count < 0 || tables > header.size)
+        return -1;
+    // the strings come last, so a well-formed snapshot ends with a terminator
+    if (header.size > tables && data[header.size - 1] != '\0')
+        return -1;
+    // lookups probe the index until an empty slot, so it must be larger than
+    // the number of arguments
+    if ((header.index_size & (header.index_size - 1)) != 0 || (header.index_size && header.index_size <= header.count) || header.program >= header.size || header.usage >= header.size || header.description >= header.size || header.epilog >= header.size)
+        return -1;
+
+    // everything not in the snapshot starts out empty
+    myargs_init_parser(parser);
+
+    // one block holds the argument records, the parser's own values, the name
+    // index and the sorted names; the tables are copied so the snapshot needs
+    // no particular alignment
+    size_t records = sizeof(Argument) * (size_t)header.count;
+    size_t values = sizeof(ArgumentValue) * (size_t)header.count;
+    size_t lists = sizeof(int) * (size_t)(header.index_size + header.sorted_count);
+    size_t tail_offset = (records + values + lists + 7) & ~(size_t)7;
+    char *block = (char *)myargs_heap_alloc(tail_offset + extra + 1);
+    if (!block)
+    {
+        fprintf(stderr, "Out of memory\n");
+        exit(EXIT_FAILURE);
+    }
+    if (tail)
+        *tail = block + tail_offset;
+
+    const char *strings = data;
+    size_t offset = sizeof(ArgumentSchema);
+    parser->arguments = (Argument *)block;
+    for (int i = 0; i < header.count; i++)
+    {
+        ArgumentSchemaEntry entry;
+        memcpy(&entry, data + offset, sizeof(entry));
+        offset += sizeof(entry);
+        if (!entry.name || entry.name < tables || entry.name >= header.size || entry.help >= header.size || entry.def_val >= header.size || entry.choices >= header.size)
+        {
+            myargs_heap_free(block);
+            return -1;
+        }
+
+        Argument *argument = &parser->arguments[i];
+        argument->name = (char *)(entry.name ? strings + entry.name : NULL);
+        argument->help = (char *)(entry.help ? strings + entry.help : NULL);
+        argument->def_val = (char *)(entry.def_val ? strings + entry.def_val : NULL);
+        argument->choices = (char *)(entry.choices ? strings + entry.choices : NULL);
+        argument->env_value = NULL;
+        argument->config_value = NULL;
+        argument->hash = entry.hash;
+        argument->required = entry.required;
+        argument->count = entry.count;
+        argument->sym = entry.sym;
+        argument->type = (Type)entry.type;
+        argument->value_type = (ValueType)entry.value_type;
+    }
+
+    parser->result.values = (ArgumentValue *)(block + records);
+    parser->result.capacity = header.count;
+    memset(parser->result.values, 0, values);
+    parser->index = (int *)(block + records + values);
+    parser->sorted = parser->index + header.index_size;
+    memcpy(parser->index, data + offset, lists);
+    int empty = 0;
+    for (int k = 0; k < header.index_size + header.sorted_count; k++)
+    {
+        if (parser->index[k] >= header.count || (k >= header.index_size && parser->index[k] < 0))
+        {
+            myargs_heap_free(block);
+            return -1;
+        }
+        empty += k < header.index_size && parser->index[k] < 0;
+    }
+    if (header.index_size && !empty)
+    {
+        myargs_heap_free(block);
+        return -1;
+    }
+    for (int k = 0; k < 256; k++)
+        parser->syms[k] = header.syms[k] < header.count ? header.syms[k] : -1;
+
+    parser->count = header.count;
+    parser->capacity = header.count;
+    parser->index_size = header.index_size;
+    parser->sorted_count = header.sorted_count;
+    parser->program = (char *)(header.program ? strings + header.program : NULL);
+    parser->usage = (char *)(header.usage ? strings + header.usage : NULL);
+    parser->description = (char *)(header.description ? strings + header.description : NULL);
+    parser->epilog = (char *)(header.epilog ? strings + header.epilog : NULL);
+    parser->help_column = header.help_column;
+    parser->help_columns = header.help_columns;
+    parser->prefix_char = header.prefix_char;
+    parser->fromfile_prefix_char = header.fromfile_prefix_char;
+    parser->add_help = header.add_help;
+    parser->allow_abbrev = header.allow_abbrev;
+    parser->exit_on_error = header.exit_on_error;
+    parser->zero_copy = header.zero_copy;
+    parser->lazy = header.lazy;
+    parser->schema = snapshot;
+    parser->frozen = true;
+    return 0;
+}
+
+int load_schema(ArgumentParser *parser, const void *snapshot, size_t size)
+{
+    ArgumentPhase phase;
+    myargs_check_profile();
+    myargs_phase_begin(&phase);
+    if (myargs_load_schema(parser, snapshot, size, 0, NULL) != 0)
+        return -1;
+    myargs_phase_end(&phase, PHASE_INIT, "load_schema", parser, NULL, NULL);
+    return 0;
+}
+
+size_t save_state(const ArgumentParser *parser, const ArgumentResult *result, void *buffer, size_t size)
+{
+    if (!result)
+        result = &parser->result;
+    size_t schema_size = save_schema(parser, NULL, 0);
+    if (schema_size == 0 || result->capacity < parser->count)
+        return 0;
+
+    // finish lazily kept values, so the region only holds final ones
+    int value_count = 0;
+    for (int i = 0; i < parser->count; i++)
+        value_count += myargs_value(result, i)->nvalues;
+
+    size_t start = (schema_size + 7) & ~(size_t)7;
+    size_t tables = start + sizeof(ArgumentState) + sizeof(ArgumentStateEntry) * (size_t)parser->count + sizeof(uint32_t) * (size_t)value_count;
+    size_t total = tables;
+    for (int pass = 0; pass < 2; pass++)
+    {
+        // the first pass measures the strings, the second writes everything
+        char *data = pass ? (char *)buffer : NULL;
+        if (pass && (!buffer || size < total))
+            break;
+        if (data)
+        {
+            save_schema(parser, data, schema_size);
+            memset(data + schema_size, 0, start - schema_size);
+        }
+
+        size_t used = tables;
+        size_t offset = start + sizeof(ArgumentState);
+        size_t list = start + sizeof(ArgumentState) + sizeof(ArgumentStateEntry) * (size_t)parser->count;
+        int listed = 0;
+        for (int i = 0; i < parser->count; i++)
+        {
+            const ArgumentValue *slot = &result->values[i];
+            ArgumentStateEntry entry;
+            memset(&entry, 0, sizeof(entry));
+            entry.value = myargs_schema_string(data, &used, slot->value);
+            entry.length = slot->value ? (uint32_t)strlen(slot->value) : 0;
+            entry.values = (uint32_t)listed;
+            entry.nvalues = slot->nvalues;
+            memcpy(&entry.integer, &slot->integer, sizeof(entry.integer));
+            for (int k = 0; k < slot->nvalues; k++, listed++)
+            {
+                uint32_t value = myargs_schema_string(data, &used, slot->values[k]);
+                if (data)
+                    memcpy(data + list + sizeof(uint32_t) * (size_t)listed, &value, sizeof(value));
+            }
+            if (data)
+                memcpy(data + offset, &entry, sizeof(entry));
+            offset += sizeof(entry);
+        }
+
+        total = used;
+        if (data)
+        {
+            ArgumentState header;
+            header.magic = MYARGS_STATE_MAGIC;
+            header.version = MYARGS_STATE_VERSION;
+            header.size = (uint32_t)total;
+            header.schema_size = (uint32_t)schema_size;
+            header.count = parser->count;
+            header.value_count = value_count;
+            memcpy(data + start, &header, sizeof(header));
+        }
+    }
+    return total;
+}
+
+int load_state(ArgumentParser *parser, const void *region, size_t size)
+{
+    ArgumentPhase phase;
+    myargs_check_profile();
+    myargs_phase_begin(&phase);
+    const char *data = (const char *)region;
+    ArgumentSchema schema;
+    ArgumentState header;
+    if (size < sizeof(schema))
+        return -1;
+    memcpy(&schema, data, sizeof(schema));
+    size_t start = ((size_t)schema.size + 7) & ~(size_t)7;
+    if (schema.size > size || start + sizeof(header) > size)
+        return -1;
+    memcpy(&header, data + start, sizeof(header));
+    size_t tables = start + sizeof(ArgumentState) + sizeof(ArgumentStateEntry) * (size_t)header.count + sizeof(uint32_t) * (size_t)header.value_count;
+    if (header.magic != MYARGS_STATE_MAGIC || header.version != MYARGS_STATE_VERSION || header.size > size || header.schema_size != schema.size || header.count != schema.count || header.value_count < 0 || tables > header.size)
+        return -1;
+    // the strings come last, so a well-formed region ends with a terminator
+    if (header.size > tables && data[header.size - 1] != '\0')
+        return -1;
+
+    char **values;
+    if (myargs_load_schema(parser, data, schema.size, sizeof(char *) * (size_t)header.value_count, (void **)&values) != 0)
+        return -1;
+
+    size_t list = start + sizeof(ArgumentState) + sizeof(ArgumentStateEntry) * (size_t)header.count;
+    for (int k = 0; k < header.value_count; k++)
+    {
+        uint32_t value;
+        memcpy(&value, data + list + sizeof(uint32_t) * (size_t)k, sizeof(value));
+        if (value < tables || value >= header.size)
+        {
+            free_parser(parser);
+            return -1;
+        }
+        values[k] = (char *)data + value;
+    }
+
+    size_t offset = start + sizeof(ArgumentState);
+    for (int i = 0; i < header.count; i++)
+    {
+        ArgumentStateEntry entry;
+        memcpy(&entry, data + offset + sizeof(entry) * (size_t)i, sizeof(entry));
+        bool in_bounds = !entry.value || (entry.value >= tables && entry.value < header.size && entry.length < header.size - entry.value);
+        if (!in_bounds || entry.nvalues < 0 || entry.values > (uint32_t)header.value_count || (uint32_t)entry.nvalues > (uint32_t)header.value_count - entry.values)
+        {
+            free_parser(parser);
+            return -1;
+        }
+
+        ArgumentValue *slot = &parser->result.values[i];
+        slot->value = entry.value ? (char *)data + entry.value : NULL;
+        slot->length = entry.length;
+        slot->values = entry.nvalues ? values + entry.values : NULL;
+        slot->nvalues = entry.nvalues;
+        memcpy(&slot->integer, &entry.integer, sizeof(slot->integer));
+    }
+    parser->result.parser = parser;
+    myargs_phase_end(&phase, PHASE_INIT, "load_state", parser, NULL, NULL);
+    return 0;
+}
+
+void reset_result(ArgumentResult *result)
+{
+    myargs_release_files(result);
+    myargs_arena_reset(&result->arena);
+    result->command = -1;
+    result->streaming = false;
+    result->open_argument = -1;
+    myargs_clear_diagnostics(result);
+    if (result->values)
+        memset(result->values, 0, sizeof(ArgumentValue) * (size_t)result->capacity);
+    result->value_pool = NULL;
+    result->value_pool_size = 0;
+    result->value_pool_used = 0;
+}
+
+void reset_parser_values(ArgumentParser *parser)
+{
+    reset_result(&parser->result);
+}
+
+void free_result(ArgumentResult *result)
+{
+    if (!result)
+        return;
+
+    myargs_release_files(result);
+    myargs_arena_free(&result->arena);
+    if (result->owns_values)
+        myargs_heap_free(result->values);
+    myargs_clear_result(result);
+}
+
+void init_batch(ArgumentBatch *batch)
+{
+    batch->rows = 0;
+    batch->columns = 0;
+    batch->column = NULL;
+    batch->status = NULL;
+    myargs_clear_result(&batch->scratch);
+}
+
+ArgumentStatus parse_args_batch(const ArgumentParser *parser, int n, const int argcs[], const char *const *const argvs[], ArgumentBatch *batch)
+{
+    ArgumentResult *scratch = &batch->scratch;
+    myargs_reserve_result(parser, scratch);
+    reset_result(scratch);
+
+    batch->rows = n;
+    batch->columns = parser->count;
+    batch->column = (ArgumentColumn *)myargs_result_alloc(scratch, sizeof(ArgumentColumn) * parser->count);
+    batch->status = (ArgumentStatus *)myargs_result_alloc(scratch, sizeof(ArgumentStatus) * n);
+    for (int i = 0; i < parser->count; i++)
+    {
+        const Argument *argument = &parser->arguments[i];
+        ArgumentColumn *column = &batch->column[i];
+        column->values = (char **)myargs_result_alloc(scratch, sizeof(char *) * n);
+        column->spans = myargs_is_multi(argument) ? (char ***)myargs_result_alloc(scratch, sizeof(char **) * n) : NULL;
+        column->nvalues = myargs_is_multi(argument) ? (int *)myargs_result_alloc(scratch, sizeof(int) * n) : NULL;
+        column->integers = argument->value_type != VALUE_STRING ? (long long *)myargs_result_alloc(scratch, sizeof(long long) * n) : NULL;
+    }
+
+    for (int row = 0; row < n; row++)
+    {
+        // values copied into the arena and spans of the pool stay valid for
+        // the whole batch: only the slots are cleared, and the next row
+        // appends to the pool instead of rewinding it
+        memset(scratch->values, 0, sizeof(ArgumentValue) * (size_t)parser->count);
+        scratch->diagnostics.row = row;
+        scratch->diagnostics.row_status = ARGUMENT_OK;
+        myargs_parse(parser, scratch, argcs[row], argvs[row]);
+        batch->status[row] = scratch->diagnostics.row_status;
+
+        for (int i = 0; i < parser->count; i++)
         {
-            if (format[i] == '%')
+            const ArgumentValue *slot = myargs_value(scratch, i);
+            ArgumentColumn *column = &batch->column[i];
+            column->values[row] = slot->value;
+            if (column->spans)
             {
-                i++;
+                column->spans[row] = slot->values;
+                column->nvalues[row] = slot->nvalues;
+            }
+            if (column->integers)
+                column->integers[row] = slot->integer;
+        }
+    }
+    scratch->diagnostics.row = -1;
+    return myargs_status(scratch);
+}
 
-                if (format[i] == 'p') // program
-                {
-                    parser->program = strdup(va_arg(args, const char *));
-                }
-                else if (format[i] == 'u') // usage
-                {
-                    parser->usage = strdup(va_arg(args, const char *));
-                }
-                else if (format[i] == 'd') // description
-                {
-                    parser->description = strdup(va_arg(args, const char *));
-                }
-                else if (format[i] == 'D') // argument_default
-                {
-                    parser->argument_default = strdup(va_arg(args, const char *));
-                }
-                else if (format[i] == 'e') // epilog
-                {
-                    parser->program = strdup(va_arg(args, const char *));
-                }
-                else if (format[i] == 'c') // prefix_chars
-                {
-                    parser->prefix_char = va_arg(args, int);
-                }
-                else if (format[i] == 'h') // add_help
-                {
-                    parser->add_help = va_arg(args, int);
-                }
-                else if (format[i] == 'a') // allow_abbrev
-                {
-                    parser->allow_abbrev = va_arg(args, int);
-                }
-                else if (format[i] == 'r') // exit_on_error
-                {
-                    parser->exit_on_error = va_arg(args, int);
-                }
+void free_batch(ArgumentBatch *batch)
+{
+    if (!batch)
+        return;
+
+    free_result(&batch->scratch);
+    init_batch(batch);
+}
+
+ArgumentHandle find_arg(const ArgumentParser *parser, const char *name)
+{
+    return myargs_find(parser, name, strlen(name));
+}
+
+const char *get_result_value(const ArgumentResult *result, ArgumentHandle handle)
+{
+    return myargs_value(result, handle)->value;
+}
+
+int get_result_flag(const ArgumentResult *result, ArgumentHandle handle)
+{
+    return myargs_value(result, handle)->value != NULL;
+}
+
+long long get_result_int(const ArgumentResult *result, ArgumentHandle handle)
+{
+    return myargs_value(result, handle)->integer;
+}
+
+double get_result_double(const ArgumentResult *result, ArgumentHandle handle)
+{
+    return myargs_value(result, handle)->real;
+}
+
+char **get_result_values(const ArgumentResult *result, ArgumentHandle handle, int *count)
+{
+    const ArgumentValue *slot = myargs_value(result, handle);
+    *count = slot->nvalues;
+    return slot->values;
+}
+
+const char *get_arg(ArgumentParser *parser, const char *name)
+{
+    int i = myargs_find(parser, name, strlen(name));
+    if (i < 0 || parser->arguments[i].type != ARG)
+        return NULL;
+
+    const ArgumentValue *slot = myargs_value(&parser->result, i);
+    if (slot->value != NULL)
+        return slot->value;
+    else
+        return *myargs_fallback(&parser->arguments[i]);
+}
+
+const char *get_kwarg(ArgumentParser *parser, const char *name)
+{
+    int i = myargs_find(parser, name, strlen(name));
+    if (i < 0 || parser->arguments[i].type != KWARG)
+        return NULL;
+
+    const ArgumentValue *slot = myargs_value(&parser->result, i);
+    if (slot->value != NULL)
+        return slot->value;
+    else
+        return *myargs_fallback(&parser->arguments[i]);
+}
+
+int get_flag(ArgumentParser *parser, const char *name)
+{
+    int i = myargs_find(parser, name, strlen(name));
+    if (i < 0 || parser->arguments[i].type != FLAG)
+        return 0;
+
+    return myargs_value(&parser->result, i)->value != NULL;
+}
+
+const char *get_arg_h(const ArgumentParser *parser, ArgumentHandle handle)
+{
+    return myargs_value(&parser->result, handle)->value;
+}
+
+const char *get_kwarg_h(const ArgumentParser *parser, ArgumentHandle handle)
+{
+    return myargs_value(&parser->result, handle)->value;
+}
+
+int get_flag_h(const ArgumentParser *parser, ArgumentHandle handle)
+{
+    return myargs_value(&parser->result, handle)->value != NULL;
+}
+
+void set_type(ArgumentParser *parser, ArgumentHandle handle, ValueType type)
+{
+    myargs_check_mutable(parser, "set the type of an argument");
+    myargs_invalidate_help(parser);
+    parser->arguments[handle].value_type = type;
+}
+
+void set_choices(ArgumentParser *parser, ArgumentHandle handle, const char *choices)
+{
+    myargs_check_mutable(parser, "set the choices of an argument");
+    myargs_invalidate_help(parser);
+    myargs_free(parser, parser->arguments[handle].choices);
+    parser->arguments[handle].choices = myargs_strdup(parser, choices);
+    parser->arguments[handle].value_type = VALUE_ENUM;
+}
+
+/**
+ * Stores a fallback value of length bytes for argument j in field, replacing
+ * the previous one. A flag only keeps a value that turns it on.
+ */
+void myargs_store_fallback(ArgumentParser *parser, int j, char **field, const char *value, size_t length)
+{
+    if (parser->arguments[j].type == FLAG)
+    {
+        bool on = (length == 1 && value[0] == '1') || (length == 4 && strncmp(value, "true", 4) == 0) || (length == 3 && strncmp(value, "yes", 3) == 0) || (length == 2 && strncmp(value, "on", 2) == 0);
+        value = on ? "true" : NULL;
+        length = 4;
+    }
+    myargs_free(parser, *field);
+    *field = value ? myargs_strndup(parser, value, length) : NULL;
+}
+
+void load_env(ArgumentParser *parser, const char *prefix)
+{
+    myargs_check_mutable(parser, "load the environment");
+    for (int i = 0; i < parser->count; i++)
+    {
+        myargs_free(parser, parser->arguments[i].env_value);
+        parser->arguments[i].env_value = NULL;
+    }
+
+    size_t prefix_length = strlen(prefix);
+    for (char **variable = environ; *variable; variable++)
+    {
+        const char *equals = strchr(*variable, '=');
+        if (!equals || strncmp(*variable, prefix, prefix_length) != 0)
+            continue;
+
+        // MYAPP_DRY_RUN names --dry-run, or --dry_run if there is no such option
+        const char *key = *variable + prefix_length;
+        size_t length = (size_t)(equals - key);
+        char name[128];
+        if (length == 0 || length >= sizeof(name))
+            continue;
+        for (size_t k = 0; k < length; k++)
+            name[k] = key[k] == '_' ? '-' : (char)tolower((unsigned char)key[k]);
+        int j = myargs_find(parser, name, length);
+        if (j < 0)
+        {
+            for (size_t k = 0; k < length; k++)
+                name[k] = key[k] == '_' ? '_' : name[k];
+            j = myargs_find(parser, name, length);
+        }
+        if (j >= 0)
+            myargs_store_fallback(parser, j, &parser->arguments[j].env_value, equals + 1, strlen(equals + 1));
+    }
+}
+
+int load_config(ArgumentParser *parser, const char *path)
+{
+    myargs_check_mutable(parser, "load a config file");
+    char *data = NULL;
+    size_t size = 0;
+
+#ifdef MYARGS_MMAP
+    int fd = open(path, O_RDONLY);
+    struct stat info;
+    if (fd < 0 || fstat(fd, &info) != 0)
+    {
+        if (fd >= 0)
+            close(fd);
+        return -1;
+    }
+    size = (size_t)info.st_size;
+    if (size > 0)
+    {
+        void *mapping = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping == MAP_FAILED)
+        {
+            close(fd);
+            return -1;
+        }
+        data = (char *)mapping;
+    }
+    close(fd);
+#else
+    // a stream that cannot be sized, such as a pipe, is refused rather than
+    // read into a buffer of (size_t)-1 + 1 bytes
+    FILE *stream = fopen(path, "rb");
+    long length = -1;
+    if (!stream || fseek(stream, 0, SEEK_END) != 0 || (length = ftell(stream)) < 0 || !(data = (char *)myargs_heap_alloc((size_t)length + 1)))
+    {
+        if (stream)
+            fclose(stream);
+        return -1;
+    }
+    size = (size_t)length;
+    rewind(stream);
+    size = fread(data, 1, size, stream);
+    fclose(stream);
+#endif // MYARGS_MMAP
+
+    for (int i = 0; i < parser->count; i++)
+    {
+        myargs_free(parser, parser->arguments[i].config_value);
+        parser->arguments[i].config_value = NULL;
+    }
+
+    // the mapping is only read: values are copied out, so it is released below
+    const char *end = data + size;
+    for (const char *line = data; line < end;)
+    {
+        const char *next = (const char *)memchr(line, '\n', (size_t)(end - line));
+        const char *stop = next ? next : end;
+        while (line < stop && isspace((unsigned char)*line))
+            line++;
+        const char *equals = (const char *)memchr(line, '=', (size_t)(stop - line));
+        if (equals && *line != '#' && *line != ';' && *line != '[')
+        {
+            const char *name_end = equals;
+            while (name_end > line && isspace((unsigned char)name_end[-1]))
+                name_end--;
+            const char *value = equals + 1;
+            const char *value_end = stop;
+            while (value < value_end && isspace((unsigned char)*value))
+                value++;
+            while (value_end > value && isspace((unsigned char)value_end[-1]))
+                value_end--;
+            if (value_end - value >= 2 && *value == '"' && value_end[-1] == '"')
+            {
+                value++;
+                value_end--;
             }
+
+            int j = myargs_find(parser, line, (size_t)(name_end - line));
+            if (j >= 0)
+                myargs_store_fallback(parser, j, &parser->arguments[j].config_value, value, (size_t)(value_end - value));
         }
-        // Clean up argument list
-        va_end(args);
+        line = next ? next + 1 : end;
     }
 
-    if (parser->add_help)
+#ifdef MYARGS_MMAP
+    if (data)
+        munmap(data, size);
+#else
+    myargs_heap_free(data);
+#endif // MYARGS_MMAP
+    return 0;
+}
+
+long long get_kwarg_int(ArgumentParser *parser, const char *name)
+{
+    int i = myargs_find(parser, name, strlen(name));
+    if (i < 0 || parser->arguments[i].type != KWARG || parser->arguments[i].value_type == VALUE_DOUBLE)
+        return 0;
+
+    return myargs_value(&parser->result, i)->integer;
+}
+
+double get_kwarg_double(ArgumentParser *parser, const char *name)
+{
+    int i = myargs_find(parser, name, strlen(name));
+    if (i < 0 || parser->arguments[i].type != KWARG || parser->arguments[i].value_type != VALUE_DOUBLE)
+        return 0;
+
+    return myargs_value(&parser->result, i)->real;
+}
+
+char **get_arg_values(ArgumentParser *parser, const char *name, int *count)
+{
+    int i = myargs_find(parser, name, strlen(name));
+    if (i < 0 || parser->arguments[i].type != ARG)
     {
-        add_flag(parser, 'h', "help", "Shows this help Menu");
+        *count = 0;
+        return NULL;
     }
+
+    return get_values_h(parser, i, count);
+}
+
+char **get_values_h(const ArgumentParser *parser, ArgumentHandle handle, int *count)
+{
+    const ArgumentValue *slot = myargs_value(&parser->result, handle);
+    *count = slot->nvalues;
+    return slot->values;
+}
+
+long long get_int_h(const ArgumentParser *parser, ArgumentHandle handle)
+{
+    return myargs_value(&parser->result, handle)->integer;
+}
+
+double get_double_h(const ArgumentParser *parser, ArgumentHandle handle)
+{
+    return myargs_value(&parser->result, handle)->real;
+}
+
+void print_arg_help(ArgumentParser *parser, int i)
+{
+    myargs_print_option(parser, i);
 };
 
-void init_parser(ArgumentParser *parser, const char *program, const char *usage, const char *description, const char *epilog)
+void print_flag_help(ArgumentParser *parser, int i)
 {
-    parser->program = strdup(program);
-    parser->usage = strdup(usage);
-    parser->description = strdup(description);
-    parser->epilog = strdup(epilog);
-    parser->arguments = NULL;
-    parser->count = 0;
-    parser->prefix_char = '-';
-    parser->add_help = true;
-    parser->allow_abbrev = true;
-    parser->exit_on_error = true;
+    myargs_print_option(parser, i);
+};
+
+void print_kwarg_help(ArgumentParser *parser, int i)
+{
+    myargs_print_option(parser, i);
+};
+
+/**
+ * Renders the help of format_help, or returns it from the cache, without
+ * timing it, so print_help's phase does not hold a second one.
+ */
+const char *myargs_format_help(ArgumentParser *parser, int description, int usage, int epilog, int group, size_t *length)
+{
+    bool color = myargs_use_color(parser);
+    size_t width = myargs_help_width(parser);
+    int flags = (description ? 1 : 0) | (usage ? 2 : 0) | (epilog ? 4 : 0) | (group ? 8 : 0) | (color ? 16 : 0);
+    if (!parser->help_text || parser->help_flags != flags || parser->help_columns != width)
+    {
+        myargs_heap_free(parser->help_text);
+        parser->help_text = NULL;
+        if (!parser->help_column || parser->help_columns != width)
+            myargs_layout_help(parser, width);
+
+        // size the buffer from the strings up front so it is filled without
+        // growing: each option adds its name, help and default, the padding
+        // of its column and the fixed text and colour codes around them
+        size_t estimate = 64 + (parser->description ? strlen(parser->description) : 0) + (parser->usage ? strlen(parser->usage) : 0) + (parser->epilog ? strlen(parser->epilog) : 0);
+        for (int i = 0; i < parser->count; i++)
+        {
+            const Argument *argument = &parser->arguments[i];
+            estimate += 96 + parser->help_column + strlen(argument->name) + (argument->help ? strlen(argument->help) : 0) + (argument->def_val ? strlen(argument->def_val) : 0) + (argument->choices ? 2 * strlen(argument->choices) : 0);
+        }
+        size_t command_column = 0;
+        for (int i = 0; i < parser->command_count; i++)
+        {
+            size_t name_length = strlen(parser->commands[i].name);
+            command_column = name_length > command_column ? name_length : command_column;
+            estimate += 32 + name_length + (parser->commands[i].help ? strlen(parser->commands[i].help) : 0);
+        }
+        estimate += parser->command_count * command_column;
+
+        ArgumentBuffer buffer = {NULL, 0, 0};
+        myargs_buffer_reserve(&buffer, estimate);
+        buffer.data[0] = '\0';
+        if (description && parser->description && *parser->description)
+            myargs_buffer_printf(&buffer, "%s\n", parser->description);
+        if (usage && parser->usage && *parser->usage)
+            myargs_buffer_printf(&buffer, "%s\n", parser->usage);
+
+        bool positionals = false;
+        for (int i = 0; i < parser->count && group; i++)
+            positionals = positionals || parser->arguments[i].type == ARG;
+        if (positionals)
+        {
+            myargs_buffer_printf(&buffer, "%sPositional arguments:\n", buffer.length ? "\n" : "");
+            for (int i = 0; i < parser->count; i++)
+            {
+                if (parser->arguments[i].type == ARG)
+                    myargs_format_option(parser, &buffer, i, color, width);
+            }
+        }
+        myargs_buffer_printf(&buffer, "%sOptions:\n", buffer.length ? "\n" : "");
+        for (int i = 0; i < parser->count; i++)
+        {
+            if (!positionals || parser->arguments[i].type != ARG)
+                myargs_format_option(parser, &buffer, i, color, width);
+        }
+
+        // subcommands are listed from their registration, without building them
+        if (parser->command_count)
+            myargs_buffer_printf(&buffer, "\nCommands:\n");
+        for (int i = 0; i < parser->command_count; i++)
+        {
+            const ArgumentCommand *command = &parser->commands[i];
+            size_t position = command_column + 4;
+            myargs_buffer_printf(&buffer, "  %s%-*s%s  ", color ? NT : "", (int)command_column, command->name, color ? NC : "");
+            if (command->help)
+                myargs_buffer_wrap(&buffer, command->help, color ? HT : "", color ? NC : "", position, position + 20 > width ? (size_t)-1 : width, &position);
+            myargs_buffer_printf(&buffer, "\n");
+        }
+
+        if (epilog && parser->epilog && *parser->epilog)
+            myargs_buffer_printf(&buffer, "\n%s\n", parser->epilog);
+
+        parser->help_text = buffer.data;
+        parser->help_length = buffer.length;
+        parser->help_flags = flags;
+        parser->help_columns = width;
+    }
+
+    if (length)
+        *length = parser->help_length;
+    return parser->help_text;
+}
+
+const char *format_help(ArgumentParser *parser, int description, int usage, int epilog, int group, size_t *length)
+{
+    ArgumentPhase phase;
+    myargs_phase_begin(&phase);
+    size_t help_length;
+    const char *text = myargs_format_help(parser, description, usage, epilog, group, &help_length);
+    myargs_phase_end(&phase, PHASE_HELP, "format_help", parser, NULL, ",\"length\":%llu", (unsigned long long)help_length);
+    if (length)
+        *length = help_length;
+    return text;
+}
+
+void print_help(ArgumentParser *parser, int description, int usage, int epilog, int group)
+{
+    if (parser == NULL)
+    {
+        return;
+    }
+
+    ArgumentPhase phase;
+    myargs_phase_begin(&phase);
+    size_t length;
+    const char *text = myargs_format_help(parser, description, usage, epilog, group, &length);
+    myargs_write_help(text, length);
+    myargs_phase_end(&phase, PHASE_HELP, "print_help", parser, NULL, ",\"length\":%llu", (unsigned long long)length);
+}
+
+/**
+ * Appends the candidates for word, one per line. Long options come from the
+ * range of the sorted name list that starts with the word.
+ */
+void myargs_complete_word(const ArgumentParser *parser, ArgumentBuffer *buffer, const char *word)
+{
+    size_t length = strlen(word);
+    if (word[0] == '-' && word[1] == '-')
+    {
+        const char *name = word + 2;
+        const char *equals = strchr(name, '=');
+        if (equals)
+        {
+            int j = myargs_find(parser, name, (size_t)(equals - name));
+            const char *choice = j >= 0 ? parser->arguments[j].choices : NULL;
+            size_t prefix = strlen(equals + 1);
+            while (choice && *choice)
+            {
+                size_t choice_length = strcspn(choice, ",");
+                if (choice_length >= prefix && strncmp(choice, equals + 1, prefix) == 0)
+                    myargs_buffer_printf(buffer, "%.*s%.*s\n", (int)(equals + 1 - word), word, (int)choice_length, choice);
+                choice += choice_length + (choice[choice_length] == ',');
+            }
+            return;
+        }
+
+        for (int i = myargs_lower_bound(parser, name, length - 2); i < parser->sorted_count; i++)
+        {
+            const char *candidate = parser->arguments[parser->sorted[i]].name;
+            if (strncmp(candidate, name, length - 2) != 0)
+                break;
+            myargs_buffer_printf(buffer, "--%s\n", candidate);
+        }
+        return;
+    }
+
+    if (word[0] == '-')
+    {
+        // a lone dash lists the short options; a bundle is already complete
+        for (int i = 0; i < parser->sorted_count && length == 1; i++)
+        {
+            if (parser->arguments[parser->sorted[i]].sym != '0')
+                myargs_buffer_printf(buffer, "-%c\n", parser->arguments[parser->sorted[i]].sym);
+        }
+        return;
+    }
+
+    for (int i = 0; i < parser->command_count; i++)
+    {
+        if (strncmp(parser->commands[i].name, word, length) == 0)
+            myargs_buffer_printf(buffer, "%s\n", parser->commands[i].name);
+    }
+    for (int i = 0; i < parser->sorted_count && length == 0; i++)
+        myargs_buffer_printf(buffer, "--%s\n", parser->arguments[parser->sorted[i]].name);
+}
 
-    if (parser->add_help)
+int complete_args(ArgumentParser *parser, int argc, const char *const argv[])
+{
+    if (argc < 2 || strcmp(argv[1], "--__complete") != 0)
+        return 0;
+
+    // descend into the subcommands named before the word being completed
+    int last = argc - 1;
+    for (int i = 2; i < last; i++)
     {
-        add_flag(parser, 'h', "help", "Shows this help Menu");
+        ArgumentToken info;
+        myargs_classify(argv[i], &info);
+        int command = info.kind == TOKEN_BARE && !info.value ? myargs_find_command(parser, info.name, info.length) : -1;
+        if (command >= 0)
+            parser = get_command_parser(parser, command);
     }
+
+    ArgumentBuffer buffer = {NULL, 0, 0};
+    myargs_buffer_reserve(&buffer, 256);
+    buffer.data[0] = '\0';
+    myargs_complete_word(parser, &buffer, last >= 2 ? argv[last] : "");
+    myargs_write_help(buffer.data, buffer.length);
+    myargs_heap_free(buffer.data);
+    return 1;
 }
 
-void add_arg(ArgumentParser *parser, char sym, const char *name, int required, int nargs, const char *default_value, const char *help)
+/**
+ * Appends the option and subcommand names of a parser, separated by spaces.
+ */
+void myargs_buffer_words(const ArgumentParser *parser, ArgumentBuffer *buffer)
 {
-    parser->arguments = (Argument *)realloc(parser->arguments, sizeof(Argument) * (parser->count + 1));
-    parser->arguments[parser->count].name = strdup(name);
-    parser->arguments[parser->count].required = required;
-    parser->arguments[parser->count].def_val = default_value ? strdup(default_value) : NULL;
-    parser->arguments[parser->count].value = NULL;
-    parser->arguments[parser->count].sym = sym ? sym : '0';
-    parser->arguments[parser->count].help = help ? strdup(help) : NULL;
-    parser->arguments[parser->count].type = ARG;
-    parser->arguments[parser->count].count = nargs;
-    parser->count++;
+    for (int i = 0; i < parser->sorted_count; i++)
+    {
+        const Argument *argument = &parser->arguments[parser->sorted[i]];
+        if (argument->sym != '0')
+            myargs_buffer_printf(buffer, "-%c ", argument->sym);
+        myargs_buffer_printf(buffer, "--%s ", argument->name);
+    }
+    for (int i = 0; i < parser->command_count; i++)
+        myargs_buffer_printf(buffer, "%s ", parser->commands[i].name);
+    if (buffer->length && buffer->data[buffer->length - 1] == ' ')
+        buffer->data[--buffer->length] = '\0';
 }
 
-void add_kwarg(ArgumentParser *parser, char sym, const char *name, int required, const char *default_value, const char *help)
+/**
+ * Appends the first length bytes of text as a single-quoted shell word,
+ * turning each separator (or none, for 0) into a space as it goes, so the
+ * escaping of a quote cannot shift what is converted.
+ */
+void myargs_buffer_quote_span(ArgumentBuffer *buffer, const char *text, size_t length, char separator)
 {
-    parser->arguments = (Argument *)realloc(parser->arguments, sizeof(Argument) * (parser->count + 1));
-    parser->arguments[parser->count].name = strdup(name);
-    parser->arguments[parser->count].required = required;
-    parser->arguments[parser->count].def_val = default_value ? strdup(default_value) : NULL;
-    parser->arguments[parser->count].value = NULL;
-    parser->arguments[parser->count].sym = sym ? sym : '0';
-    parser->arguments[parser->count].help = help ? strdup(help) : NULL;
-    parser->arguments[parser->count].type = KWARG;
-    parser->count++;
+    myargs_buffer_printf(buffer, "'");
+    for (size_t i = 0; i < length; i++)
+    {
+        if (text[i] == '\'')
+            myargs_buffer_printf(buffer, "'\\''");
+        else
+            myargs_buffer_printf(buffer, "%c", separator && text[i] == separator ? ' ' : text[i]);
+    }
+    myargs_buffer_printf(buffer, "'");
 }
 
-void add_flag(ArgumentParser *parser, char sym, const char *name, const char *help)
+/**
+ * Appends text as a single-quoted shell word.
+ */
+void myargs_buffer_quote(ArgumentBuffer *buffer, const char *text)
 {
-    parser->arguments = (Argument *)realloc(parser->arguments, sizeof(Argument) * (parser->count + 1));
-    parser->arguments[parser->count].name = strdup(name);
-    parser->arguments[parser->count].required = 0;
-    parser->arguments[parser->count].def_val = NULL;
-    parser->arguments[parser->count].value = NULL;
-    parser->arguments[parser->count].sym = sym ? sym : '0';
-    parser->arguments[parser->count].help = help ? strdup(help) : NULL;
-    parser->arguments[parser->count].type = FLAG;
-    parser->count++;
+    myargs_buffer_quote_span(buffer, text, text ? strlen(text) : 0, 0);
 }
 
-void parse_args(ArgumentParser *parser, int argc, char *argv[])
+/**
+ * Appends the fish completions of one parser, applied while condition holds.
+ */
+void myargs_buffer_fish(const ArgumentParser *parser, ArgumentBuffer *buffer, const char *program, const char *condition)
 {
-    for (int i = 1; i < argc; i++)
+    for (int i = 0; i < parser->count; i++)
     {
-        if (strncmp(argv[i], "--", 2) == 0)
+        const Argument *argument = &parser->arguments[i];
+        myargs_buffer_printf(buffer, "complete -c %s -n '%s' -l %s", program, condition, argument->name);
+        if (argument->sym != '0')
+            myargs_buffer_printf(buffer, " -s %c", argument->sym);
+        if (argument->type != FLAG)
+            myargs_buffer_printf(buffer, " -r");
+        if (argument->choices)
         {
-            char *arg = argv[i] + 2;
-            char *value = strchr(arg, '=');
-            if (value)
-            {
-                *value = '\0';
-                value++;
-            }
-            else
-            {
-                value = NULL;
-            }
-            for (int j = 0; j < parser->count; j++)
-            {
-                if (strcmp(parser->arguments[j].name, arg) == 0)
-                {
-                    parser->arguments[j].value = strdup(value);
-                    break;
-                }
-            }
-            for (size_t j = 0; j < parser->count; j++)
-            {
-                if (strcmp(parser->arguments[j].name, arg) == 0 && parser->arguments[j].type == FLAG)
-                {
-                    parser->arguments[j].value = strdup("true");
-                    break;
-                }
-                else if (strcmp(parser->arguments[j].name, arg) == 0 && parser->arguments[j].type == KWARG)
-                {
-                    parser->arguments[j].value = strdup(value);
-                    break;
-                }
-            }
+            myargs_buffer_printf(buffer, " -a ");
+            myargs_buffer_quote_span(buffer, argument->choices, strlen(argument->choices), ',');
+        }
+        if (argument->help)
+        {
+            myargs_buffer_printf(buffer, " -d ");
+            myargs_buffer_quote(buffer, argument->help);
         }
+        myargs_buffer_printf(buffer, "\n");
+    }
+}
+
+void print_completion(ArgumentParser *parser, const char *shell)
+{
+    // shell function names cannot hold every character a program name can
+    char program[64];
+    const char *name = parser->program && *parser->program ? parser->program : "program";
+    size_t n = 0;
+    for (; name[n] && n < sizeof(program) - 1; n++)
+        program[n] = isalnum((unsigned char)name[n]) ? name[n] : '_';
+    program[n] = '\0';
 
-        // for -o -i -s=hello or -ois=hello
-        else if (strncmp(argv[i], "-", 1) == 0)
+    ArgumentBuffer buffer = {NULL, 0, 0};
+    myargs_buffer_reserve(&buffer, 1024);
+    buffer.data[0] = '\0';
+
+    if (strcmp(shell, "fish") == 0)
+    {
+        ArgumentBuffer condition = {NULL, 0, 0};
+        myargs_buffer_printf(&condition, parser->command_count ? "not __fish_seen_subcommand_from" : "true");
+        for (int i = 0; i < parser->command_count; i++)
+            myargs_buffer_printf(&condition, " %s", parser->commands[i].name);
+
+        myargs_buffer_printf(&buffer, "complete -c %s -f\n", name);
+        myargs_buffer_fish(parser, &buffer, name, condition.data);
+        for (int i = 0; i < parser->command_count; i++)
         {
-            char *arg = argv[i] + 1;
-            char *value = strchr(arg, '=');
-            if (value)
-            {
-                *value = '\0';
-                value++;
-            }
-            else
-            {
-                value = NULL;
-            }
-            if (arg)
+            myargs_buffer_printf(&buffer, "complete -c %s -n '%s' -a %s", name, condition.data, parser->commands[i].name);
+            if (parser->commands[i].help)
             {
-                for (size_t j = 0; j < strlen(arg); j++)
-                {
-                    for (size_t k = 0; k < parser->count; k++)
-                    {
-                        if (parser->arguments[k].sym == arg[j] && parser->arguments[k].type == FLAG)
-                        {
-                            parser->arguments[k].value = strdup("true");
-                            break;
-                        }
-                        else if (parser->arguments[k].sym == arg[j] && parser->arguments[k].type == KWARG)
-                        {
-                            parser->arguments[k].value = strdup(value);
-                            break;
-                        }
-                    }
-                }
+                myargs_buffer_printf(&buffer, " -d ");
+                myargs_buffer_quote(&buffer, parser->commands[i].help);
             }
+            myargs_buffer_printf(&buffer, "\n");
+        }
+        for (int i = 0; i < parser->command_count; i++)
+        {
+            condition.length = 0;
+            myargs_buffer_printf(&condition, "__fish_seen_subcommand_from %s", parser->commands[i].name);
+            myargs_buffer_fish(get_command_parser(parser, i), &buffer, name, condition.data);
         }
+        myargs_heap_free(condition.data);
+    }
+    else
+    {
+        bool zsh = strcmp(shell, "zsh") == 0;
+        if (zsh)
+            myargs_buffer_printf(&buffer, "#compdef %s\n\n_%s() {\n    local command= i\n    for ((i = 2; i < CURRENT; i++)); do\n        case ${words[i]} in\n", name, program);
         else
+            myargs_buffer_printf(&buffer, "_%s() {\n    local cur=${COMP_WORDS[COMP_CWORD]} command= i\n    for ((i = 1; i < COMP_CWORD; i++)); do\n        case ${COMP_WORDS[i]} in\n", program);
+        for (int i = 0; i < parser->command_count; i++)
+            myargs_buffer_printf(&buffer, "            %s) command=%s; break ;;\n", parser->commands[i].name, parser->commands[i].name);
+        myargs_buffer_printf(&buffer, "        esac\n    done\n    case $command in\n");
+
+        // the words are quoted for the shell: as one word list for bash,
+        // and one by one for zsh
+        ArgumentBuffer words = {NULL, 0, 0};
+        for (int i = 0; i <= parser->command_count; i++)
         {
-            char *arg = argv[i];
-            char *value = strchr(arg, '=');
-            if (value)
-            {
-                *value = '\0';
-                value++;
-            }
-            else
-            {
-                value = NULL;
-            }
-            printf("%s", arg);
-            for (int j = 0; j < parser->count; j++)
+            const ArgumentParser *current = i < parser->command_count ? get_command_parser(parser, i) : parser;
+            myargs_buffer_printf(&buffer, "        %s) ", i < parser->command_count ? parser->commands[i].name : "*");
+            words.length = 0;
+            myargs_buffer_printf(&words, "%s", "");
+            myargs_buffer_words(current, &words);
+            if (zsh)
             {
-                if (strcmp(parser->arguments[j].name, arg) == 0)
+                myargs_buffer_printf(&buffer, "compadd --");
+                for (const char *word = words.data; *word;)
                 {
-                    parser->arguments[j].value = strdup(value);
-                    break;
+                    size_t length = strcspn(word, " ");
+                    myargs_buffer_printf(&buffer, " ");
+                    myargs_buffer_quote_span(&buffer, word, length, 0);
+                    word += length + (word[length] == ' ');
                 }
+                myargs_buffer_printf(&buffer, " ;;\n");
             }
-            for (size_t j = 0; j < parser->count; j++)
+            else
             {
-                if (strcmp(parser->arguments[j].name, arg) == 0 && parser->arguments[j].type == FLAG)
-                {
-                    parser->arguments[j].value = strdup("true");
-                    break;
-                }
-                else if (strcmp(parser->arguments[j].name, arg) == 0 && parser->arguments[j].type == KWARG)
-                {
-                    parser->arguments[j].value = strdup(value);
-                    break;
-                }
+                myargs_buffer_printf(&buffer, "COMPREPLY=($(compgen -W ");
+                myargs_buffer_quote(&buffer, words.data);
+                myargs_buffer_printf(&buffer, " -- \"$cur\")) ;;\n");
             }
         }
+        myargs_heap_free(words.data);
+        myargs_buffer_printf(&buffer, "    esac\n}\n\n");
+        if (zsh)
+            myargs_buffer_printf(&buffer, "compdef _%s %s\n", program, name);
+        else
+            myargs_buffer_printf(&buffer, "complete -F _%s %s\n", program, name);
+    }
+
+    myargs_write_help(buffer.data, buffer.length);
+    myargs_heap_free(buffer.data);
+}
+
+void free_parser(ArgumentParser *parser)
+{
+    if (!parser)
+        return;
+
+    // the parser's own result borrows its values from the parser
+    ArgumentValue *values = parser->result.values;
+    free_result(&parser->result);
+    myargs_invalidate_help(parser);
+    for (int i = 0; i < parser->command_count; i++)
+        free_parser(parser->commands[i].parser);
+
+    if (parser->schema)
+    {
+        // the strings belong to the snapshot; the records and tables share one block
+        myargs_heap_free(parser->arguments);
+        return;
+    }
+
+    if (parser->arena)
+    {
+        // everything the parser owns lives in the arena
+        myargs_arena_free(&parser->arena);
+        return;
     }
 
     for (int i = 0; i < parser->count; i++)
     {
-        if (parser->arguments[i].required && !parser->arguments[i].value)
-        {
-            fprintf(stderr, "Missing required argument: %s\n", parser->arguments[i].name);
-            exit(EXIT_FAILURE);
-        }
-        if (!parser->arguments[i].value)
+        if (!parser->names)
+            myargs_heap_free(parser->arguments[i].name);
+        if (parser->arguments[i].help)
+            myargs_heap_free(parser->arguments[i].help);
+        if (parser->arguments[i].def_val)
+            myargs_heap_free(parser->arguments[i].def_val);
+        if (parser->arguments[i].choices)
+            myargs_heap_free(parser->arguments[i].choices);
+        myargs_heap_free(parser->arguments[i].env_value);
+        myargs_heap_free(parser->arguments[i].config_value);
+    }
+    myargs_heap_free(parser->arguments);
+    myargs_heap_free(values);
+    myargs_heap_free(parser->index);
+    myargs_heap_free(parser->sorted);
+    myargs_heap_free(parser->hashes);
+
+    for (int i = 0; i < parser->command_count; i++)
+    {
+        myargs_heap_free(parser->commands[i].name);
+        myargs_heap_free(parser->commands[i].help);
+        myargs_heap_free(parser->commands[i].parser);
+    }
+    myargs_heap_free(parser->commands);
+    myargs_heap_free(parser->command_index);
+
+    if (parser->program)
+        myargs_heap_free(parser->program);
+    if (parser->usage)
+        myargs_heap_free(parser->usage);
+    if (parser->description)
+        myargs_heap_free(parser->description);
+    if (parser->epilog)
+        myargs_heap_free(parser->epilog);
+    if (parser->argument_default)
+        myargs_heap_free((char *)parser->argument_default);
+}
+
+#pragma endregion // DEFINATIONS
+
+#pragma region CPLUSPLUS
+
+#ifdef __cplusplus
+
+/**
+ * An error that stopped a parse: the argument it concerns and a message. Both
+ * point to static or parser-owned strings, so reporting one never allocates.
+ */
+class ArgumentError : public std::exception
+{
+private:
+    ArgumentError_t m_Error;
+
+public:
+    ArgumentError(const char *argument = "", const char *message = "", ArgumentStatus status = ARGUMENT_INVALID) : m_Error{argument, message, status, -1} {}
+    explicit ArgumentError(const ArgumentError_t &error) : m_Error(error) {}
+
+    const char *what() const noexcept override { return m_Error.message ? m_Error.message : ""; }
+    const char *Argument() const noexcept { return m_Error.argument ? m_Error.argument : ""; }
+    ArgumentStatus Status() const noexcept { return m_Error.status; }
+    const ArgumentError_t &Error() const noexcept { return m_Error; }
+};
+
+/**
+ * An error raised by a value that cannot be converted to its argument's type.
+ */
+class ArgumentTypeError : public ArgumentError
+{
+public:
+    using ArgumentError::ArgumentError;
+};
+
+#pragma region DECLARATIONS
+
+/**
+ * Either a value or the ArgumentError_t that prevented it, in the manner of
+ * std::expected. Checking it never throws; only Value() on an error does, or
+ * exits when exceptions are disabled.
+ */
+template <typename T>
+class Expected
+{
+private:
+    T m_Value;
+    ArgumentError_t m_Error;
+    bool m_HasValue;
+
+public:
+    Expected(T value) : m_Value(value), m_Error{nullptr, nullptr, ARGUMENT_OK, -1}, m_HasValue(true) {}
+    Expected(const ArgumentError_t &error) : m_Value(), m_Error(error), m_HasValue(false) {}
+
+    bool HasValue() const { return m_HasValue; }
+    explicit operator bool() const { return m_HasValue; }
+    const ArgumentError_t &Error() const { return m_Error; }
+    const T &operator*() const { return m_Value; }
+    T ValueOr(T fallback) const { return m_HasValue ? m_Value : fallback; }
+    const T &Value() const;
+};
+
+/**
+ * The outcome of an operation that has no value, such as Argparse::Parse.
+ */
+template <>
+class Expected<void>
+{
+private:
+    ArgumentError_t m_Error;
+    bool m_HasValue;
+
+public:
+    Expected() : m_Error{nullptr, nullptr, ARGUMENT_OK, -1}, m_HasValue(true) {}
+    Expected(const ArgumentError_t &error) : m_Error(error), m_HasValue(false) {}
+
+    bool HasValue() const { return m_HasValue; }
+    explicit operator bool() const { return m_HasValue; }
+    const ArgumentError_t &Error() const { return m_Error; }
+};
+
+/**
+ * A typed view of a registered argument. Reading it goes straight through the
+ * handle, so it is cheap enough to call from hot loops.
+ */
+template <typename T>
+class Option
+{
+private:
+    const ArgumentParser *m_Parser;
+    ArgumentHandle m_Handle;
+
+public:
+    Option(const ArgumentParser *parser, ArgumentHandle handle) : m_Parser(parser), m_Handle(handle) {}
+
+    ArgumentHandle Handle() const { return m_Handle; }
+    T Get() const;
+    operator T() const { return Get(); }
+};
+
+/**
+ * Maps the C++ type of an Option to the ValueType it is converted to.
+ */
+template <typename T>
+struct OptionType;
+
+template <>
+struct OptionType<long long>
+{
+    static const ValueType value = VALUE_INT;
+};
+
+template <>
+struct OptionType<double>
+{
+    static const ValueType value = VALUE_DOUBLE;
+};
+
+#ifdef MYARGS_CXX17
+/**
+ * The values of a multi-value argument, read as string_views. It is a view of
+ * the result's value pool, so it copies nothing and stays valid until the
+ * parser is reset or parses again.
+ */
+class ValueSpan
+{
+private:
+    char *const *m_Values;
+    size_t m_Count;
+
+public:
+    class Iterator
+    {
+    private:
+        char *const *m_At;
+
+    public:
+        explicit Iterator(char *const *at) : m_At(at) {}
+        std::string_view operator*() const { return *m_At; }
+        Iterator &operator++()
         {
-            parser->arguments[i].value = parser->arguments[i].def_val;
+            ++m_At;
+            return *this;
         }
+        bool operator==(const Iterator &other) const { return m_At == other.m_At; }
+        bool operator!=(const Iterator &other) const { return m_At != other.m_At; }
+    };
+
+    ValueSpan() : m_Values(nullptr), m_Count(0) {}
+    ValueSpan(char *const *values, size_t count) : m_Values(values), m_Count(count) {}
+
+    size_t size() const { return m_Count; }
+    bool empty() const { return m_Count == 0; }
+    std::string_view operator[](size_t i) const { return m_Values[i]; }
+    Iterator begin() const { return Iterator(m_Values); }
+    Iterator end() const { return Iterator(m_Values + m_Count); }
+};
+#endif // MYARGS_CXX17
+
+/**
+ * Owns an ArgumentParser. The parser lives on the heap, so an Argparse can be
+ * moved, together with its arena, without invalidating the Options it handed
+ * out; it cannot be copied. A moved-from Argparse may only be destroyed or
+ * assigned to.
+ */
+class Argparse
+{
+private:
+    ArgumentParser *m_Parser;
+
+    void Create();
+    Expected<void> Outcome(ArgumentStatus status) const;
+
+public:
+    Argparse();
+#ifdef MYARGS_CXX17
+    Argparse(std::string_view program, std::string_view usage = {}, std::string_view description = {}, std::string_view epilog = {});
+    Argparse(void *buffer, size_t size, std::string_view program = {}, std::string_view usage = {}, std::string_view description = {}, std::string_view epilog = {});
+#else
+    Argparse(const std::string &program, const std::string &usage, const std::string &description, const std::string &epilog);
+#endif // MYARGS_CXX17
+    Argparse(const Argparse &) = delete;
+    Argparse &operator=(const Argparse &) = delete;
+    Argparse(Argparse &&other) noexcept;
+    Argparse &operator=(Argparse &&other) noexcept;
+    ~Argparse();
+
+    ArgumentParser *Parser() const { return m_Parser; }
+
+    void Help(int description = 1, int usage = 1, int epilog = 1, int group = 1);
+    const char *HelpText(int description = 1, int usage = 1, int epilog = 1, int group = 1);
+    Expected<void> Parse(int argc, char *argv[]);
+    Expected<void> Parse(int argc, const char *const argv[]);
+    void Feed(const char *token, size_t length);
+    Expected<void> Finish();
+    void Reset();
+
+    int GetFlag(const char *name);
+    const char *GetArg(const char *name);
+    const char *GetKwarg(const char *name);
+    char **GetValues(const char *name, int *count);
+
+    template <typename T>
+    T Get(const char *name);
+
+#ifdef MYARGS_CXX17
+    /**
+     * Looks up an argument by name, which need not be NUL-terminated.
+     *
+     * @return The argument's handle, or -1.
+     */
+    ArgumentHandle Find(std::string_view name) const;
+
+    bool Flag(ArgumentHandle handle) const;
+    bool Flag(std::string_view name) const;
+
+    /**
+     * Reads the value of an argument as a view of the parser's copy, or of
+     * argv with zero_copy. Empty when the name is unknown or the argument has
+     * no value and no default.
+     */
+    std::optional<std::string_view> Value(ArgumentHandle handle) const;
+    std::optional<std::string_view> Value(std::string_view name) const;
+
+    /**
+     * Reads the converted value of an argument. Empty when the argument has no
+     * value, or its value_type holds no T: VALUE_DOUBLE for double, and for an
+     * integral T any type but VALUE_STRING and VALUE_DOUBLE.
+     */
+    template <typename T>
+    std::optional<T> Value(ArgumentHandle handle) const;
+    template <typename T>
+    std::optional<T> Value(std::string_view name) const { return Value<T>(Find(name)); }
+
+    ValueSpan Values(ArgumentHandle handle) const;
+    ValueSpan Values(std::string_view name) const;
+#endif // MYARGS_CXX17
+
+    void SetType(ArgumentHandle handle, ValueType type);
+    void SetChoices(ArgumentHandle handle, const char *choices);
+
+    Option<bool> AddFlag(char sym, const char *name, const char *help);
+    Option<const char *> AddKwarg(char sym, const char *name, int required, const char *default_value, const char *help);
+    template <typename T>
+    Option<T> AddKwarg(char sym, const char *name, int required, const char *default_value, const char *help);
+    Option<const char *> AddArg(char sym, const char *name, int required, int nargs, const char *default_value, const char *help);
+};
+
+#pragma endregion // DECLARATIONS
+
+#pragma region DEFINATIONS
+
+template <typename T>
+const T &Expected<T>::Value() const
+{
+    if (!m_HasValue)
+    {
+#if defined(__cpp_exceptions) || defined(__EXCEPTIONS) || defined(_CPPUNWIND)
+        throw ArgumentError(m_Error);
+#else
+        fprintf(stderr, "%s: %s\n", m_Error.argument ? m_Error.argument : "", m_Error.message ? m_Error.message : "");
+        exit(EXIT_FAILURE);
+#endif
+    }
+    return m_Value;
+}
+
+template <>
+inline bool Option<bool>::Get() const
+{
+    return get_flag_h(m_Parser, m_Handle);
+}
+
+template <>
+inline const char *Option<const char *>::Get() const
+{
+    return get_kwarg_h(m_Parser, m_Handle);
+}
+
+template <>
+inline long long Option<long long>::Get() const
+{
+    return get_int_h(m_Parser, m_Handle);
+}
+
+template <>
+inline double Option<double>::Get() const
+{
+    return get_double_h(m_Parser, m_Handle);
+}
+
+template <>
+inline const char *Argparse::Get<const char *>(const char *name)
+{
+    return get_kwarg(m_Parser, name);
+}
+
+template <>
+inline long long Argparse::Get<long long>(const char *name)
+{
+    return get_kwarg_int(m_Parser, name);
+}
+
+template <>
+inline int Argparse::Get<int>(const char *name)
+{
+    return (int)get_kwarg_int(m_Parser, name);
+}
+
+template <>
+inline bool Argparse::Get<bool>(const char *name)
+{
+    return get_kwarg_int(m_Parser, name) != 0;
+}
+
+template <>
+inline double Argparse::Get<double>(const char *name)
+{
+    return get_kwarg_double(m_Parser, name);
+}
+
+void Argparse::Create()
+{
+    m_Parser = (ArgumentParser *)myargs_heap_alloc(sizeof(ArgumentParser));
+    if (!m_Parser)
+    {
+        fprintf(stderr, "Out of memory\n");
+        exit(EXIT_FAILURE);
     }
 }
 
-const char *get_arg(ArgumentParser *parser, const char *name)
+Argparse::Argparse()
 {
-    for (int i = 0; i < parser->count; i++)
-    {
-        if (strcmp(parser->arguments[i].name, name) == 0)
-        {
-            if (parser->arguments[i].type == ARG)
+    Create();
+    init_parser(m_Parser, "", "", "", "");
+    // errors come back through Parse and Finish rather than ending the process
+    m_Parser->exit_on_error = false;
+};
 
-                if (parser->arguments[i].value != NULL)
-                    return parser->arguments[i].value;
-                else
-                    return parser->arguments[i].def_val;
-            else
-                return NULL;
-        }
-    }
-    return NULL;
+#ifdef MYARGS_CXX17
+Argparse::Argparse(std::string_view program, std::string_view usage, std::string_view description, std::string_view epilog)
+    : Argparse(nullptr, 0, program, usage, description, epilog)
+{
 }
 
-const char *get_kwarg(ArgumentParser *parser, const char *name)
+Argparse::Argparse(void *buffer, size_t size, std::string_view program, std::string_view usage, std::string_view description, std::string_view epilog)
 {
-    for (int i = 0; i < parser->count; i++)
-    {
-        if (strcmp(parser->arguments[i].name, name) == 0)
-        {
-            if (parser->arguments[i].type == KWARG)
+    Create();
+    // the views need not be NUL-terminated, so they are copied straight into the parser
+    init_parser_arena(m_Parser, buffer, size, NULL, NULL, NULL, NULL);
+    m_Parser->program = program.data() ? myargs_strndup(m_Parser, program.data(), program.size()) : NULL;
+    m_Parser->usage = usage.data() ? myargs_strndup(m_Parser, usage.data(), usage.size()) : NULL;
+    m_Parser->description = description.data() ? myargs_strndup(m_Parser, description.data(), description.size()) : NULL;
+    m_Parser->epilog = epilog.data() ? myargs_strndup(m_Parser, epilog.data(), epilog.size()) : NULL;
+    m_Parser->exit_on_error = false;
+}
+#else
+Argparse::Argparse(const std::string &program, const std::string &usage, const std::string &description, const std::string &epilog)
+{
+    Create();
+    init_parser(m_Parser, program.c_str(), usage.c_str(), description.c_str(), epilog.c_str());
+    m_Parser->exit_on_error = false;
+}
+#endif // MYARGS_CXX17
 
-                if (parser->arguments[i].value != NULL)
-                    return parser->arguments[i].value;
-                else
-                    return parser->arguments[i].def_val;
-            else
-                return NULL;
-        }
+Expected<void> Argparse::Outcome(ArgumentStatus status) const
+{
+    if (status == ARGUMENT_OK)
+        return Expected<void>();
+
+    // the first error may belong to the subcommand
+    const ArgumentParser *parser = m_Parser;
+    while (parser->result.diagnostics.count == 0 && parser->result.command >= 0)
+        parser = parser->commands[parser->result.command].parser;
+    if (parser->result.diagnostics.count == 0)
+    {
+        ArgumentError_t error = {"", "Parse failed", status, -1};
+        return Expected<void>(error);
     }
-    return NULL;
+    return Expected<void>(parser->result.diagnostics.errors[0]);
 }
 
-int get_flag(ArgumentParser *parser, const char *name)
+Argparse::Argparse(Argparse &&other) noexcept : m_Parser(other.m_Parser)
 {
-    for (int i = 0; i < parser->count; i++)
+    other.m_Parser = nullptr;
+}
+
+Argparse &Argparse::operator=(Argparse &&other) noexcept
+{
+    if (this != &other)
     {
-        if (strcmp(parser->arguments[i].name, name) == 0)
+        if (m_Parser)
         {
-            if (parser->arguments[i].type == FLAG)
-                if (parser->arguments[i].value != NULL)
-                    return 1;
-                else
-                    return 0;
-            else
-                return 0;
+            free_parser(m_Parser);
+            myargs_heap_free(m_Parser);
         }
+        m_Parser = other.m_Parser;
+        other.m_Parser = nullptr;
     }
-    return 0;
+    return *this;
 }
 
-void print_arg_help(ArgumentParser *parser, int i)
+void Argparse::Help(int description, int usage, int epilog, int group)
 {
-    printf("-%c --%s ", parser->arguments[i].sym ? parser->arguments[i].sym : ' ', parser->arguments[i].name);
-    printf("(required: %d , [%s] ) ", parser->arguments[i].required, parser->arguments[i].def_val ? parser->arguments[i].def_val : "None");
-    printf("= %s \n", parser->arguments[i].help ? parser->arguments[i].help : "No description");
+    print_help(m_Parser, description, usage, epilog, group);
 };
 
-void print_flag_help(ArgumentParser *parser, int i)
+const char *Argparse::HelpText(int description, int usage, int epilog, int group)
 {
-    printf("-" FT "%c" NC "--" NT "%s " NC, parser->arguments[i].sym ? parser->arguments[i].sym : '\0', parser->arguments[i].name);
-    printf(CC ":" NC HT "%s" NC "\n", parser->arguments[i].help ? parser->arguments[i].help : "");
+    return format_help(m_Parser, description, usage, epilog, group, NULL);
 };
 
-void print_kwarg_help(ArgumentParser *parser, int i)
+const char *Argparse::GetArg(const char *name)
 {
-    // -c, --color : An Enum input [allowed:<red, blue, green>, required]
-
-    printf("-" FT "%c" NC "--" NT "%s " NC, parser->arguments[i].sym ? parser->arguments[i].sym : '\0', parser->arguments[i].name);
-    printf(CC ":" NC HT "%s" NC, parser->arguments[i].help ? parser->arguments[i].help : "");
+    return get_arg(m_Parser, name);
+};
 
-    printf("[" NC HT "%s" NC, parser->arguments[i].help ? parser->arguments[i].help : "");
+int Argparse::GetFlag(const char *name)
+{
+    return get_flag(m_Parser, name);
+};
 
-    printf("[" NC "required " NC CC ": " NC " %d , [%s] ) ", parser->arguments[i].required, parser->arguments[i].def_val ? parser->arguments[i].def_val : "");
+const char *Argparse::GetKwarg(const char *name)
+{
+    return get_kwarg(m_Parser, name);
 };
 
-void print_help(ArgumentParser *parser, int description, int usage, int epilog, int group)
+#ifdef MYARGS_CXX17
+ArgumentHandle Argparse::Find(std::string_view name) const
 {
-    if (parser == NULL)
-    {
-        return;
-    }
+    return myargs_find(m_Parser, name.data(), name.size());
+}
 
-    for (int i = 0; i < parser->count; i++)
-    {
-        if (parser->arguments[i].type == FLAG)
-        {
-            print_flag_help(parser, i);
-        }
-        else if (parser->arguments[i].type == KWARG)
-        {
-            print_kwarg_help(parser, i);
-        }
-        else
-        {
-            print_arg_help(parser, i);
-        }
-    }
+bool Argparse::Flag(ArgumentHandle handle) const
+{
+    return handle >= 0 && get_flag_h(m_Parser, handle);
 }
 
-void free_parser(ArgumentParser *parser)
+bool Argparse::Flag(std::string_view name) const
 {
-    if (!parser)
-        return;
+    return Flag(Find(name));
+}
 
-    for (int i = 0; i < parser->count; i++)
-    {
-        free(parser->arguments[i].name);
-        if (parser->arguments[i].help)
-            free(parser->arguments[i].help);
-        if (parser->arguments[i].def_val)
-            free(parser->arguments[i].def_val);
-        if (parser->arguments[i].type == ARG || parser->arguments[i].type == KWARG)
-        {
-            if (parser->arguments[i].count == 1)
-            {
-                if (parser->arguments[i].value)
-                    free(parser->arguments[i].value);
-            }
-            else
-            {
-                if (parser->arguments[i].values)
-                {
-                    for (size_t j = 0; j < parser->arguments[i].count; j++)
-                    {
-                        if (parser->arguments[i].values[j])
-                            free(parser->arguments[i].values[j]);
-                    }
-                    free(parser->arguments[i].values); // Free the values array itself
-                }
-            }
-        }
-    }
-    free(parser->arguments);
+std::optional<std::string_view> Argparse::Value(ArgumentHandle handle) const
+{
+    if (handle < 0)
+        return std::nullopt;
+    const ArgumentValue *slot = myargs_value(&m_Parser->result, handle);
+    if (!slot->value)
+        return std::nullopt;
+    return std::string_view(slot->value, slot->length);
+}
 
-    if (parser->program)
-        free(parser->program);
-    if (parser->usage)
-        free(parser->usage);
-    if (parser->description)
-        free(parser->description);
-    if (parser->epilog)
-        free(parser->epilog);
+std::optional<std::string_view> Argparse::Value(std::string_view name) const
+{
+    return Value(Find(name));
 }
 
-#pragma endregion // DEFINATIONS
+template <typename T>
+std::optional<T> Argparse::Value(ArgumentHandle handle) const
+{
+    static_assert(std::is_arithmetic<T>::value, "Value<T> converts to integral and floating point types");
+    if (handle < 0)
+        return std::nullopt;
+    ValueType type = m_Parser->arguments[handle].value_type;
+    const ArgumentValue *slot = myargs_value(&m_Parser->result, handle);
+    if (!slot->value || type == VALUE_STRING || (type == VALUE_DOUBLE) != std::is_floating_point<T>::value)
+        return std::nullopt;
+    if constexpr (std::is_floating_point<T>::value)
+        return (T)slot->real;
+    else
+        return (T)slot->integer;
+}
 
-#pragma region CPLUSPLUS
+ValueSpan Argparse::Values(ArgumentHandle handle) const
+{
+    if (handle < 0)
+        return ValueSpan();
+    int count;
+    char **values = get_values_h(m_Parser, handle, &count);
+    return ValueSpan(values, (size_t)count);
+}
 
-#ifdef __cplusplus
+ValueSpan Argparse::Values(std::string_view name) const
+{
+    return Values(Find(name));
+}
+#endif // MYARGS_CXX17
 
-class ArgumentError : std::exception
+template <typename T>
+Option<T> Argparse::AddKwarg(char sym, const char *name, int required, const char *default_value, const char *help)
 {
-private:
-    ArgumentError_t m_Error;
+    ArgumentHandle handle = add_kwarg(m_Parser, sym, name, required, default_value, help);
+    set_type(m_Parser, handle, OptionType<T>::value);
+    return Option<T>(m_Parser, handle);
+}
 
-public:
-    const char *what() { return ""; };
+void Argparse::SetType(ArgumentHandle handle, ValueType type)
+{
+    set_type(m_Parser, handle, type);
 };
 
-class ArgumentTypeError : ArgumentError
+void Argparse::SetChoices(ArgumentHandle handle, const char *choices)
 {
+    set_choices(m_Parser, handle, choices);
 };
 
-#pragma region DECLARATIONS
-class Argparse
+char **Argparse::GetValues(const char *name, int *count)
 {
-private:
-    ArgumentParser m_Parser;
+    return get_arg_values(m_Parser, name, count);
+};
 
-public:
-    Argparse();
-    Argparse(std::string program, std::string usage, std::string description, std::string epilog);
-    ~Argparse();
+Expected<void> Argparse::Parse(int argc, char *argv[])
+{
+    return Parse(argc, (const char *const *)argv);
+};
 
-    void Help(int description = 1, int usage = 1, int epilog = 1, int group = 1);
-    void Parse(int argc, char *argv[]);
+Expected<void> Argparse::Parse(int argc, const char *const argv[])
+{
+    return Outcome(parse_args_const(m_Parser, argc, argv));
+};
 
-    int GetFlag(const char *name);
-    const char *GetArg(const char *name);
-    const char *GetKwarg(const char *name);
+void Argparse::Feed(const char *token, size_t length)
+{
+    parser_feed(m_Parser, token, length);
+};
 
-    void AddFlag(char sym, const char *name, const char *help);
-    void AddKwarg(char sym, const char *name, int required, const char *default_value, const char *help);
-    void AddArg(char sym, const char *name, int required, int nargs, const char *default_value, const char *help);
+Expected<void> Argparse::Finish()
+{
+    return Outcome(parser_finish(m_Parser));
 };
 
-#pragma endregion // DECLARATIONS
+void Argparse::Reset()
+{
+    reset_parser_values(m_Parser);
+};
 
-#pragma region DEFINATIONS
+Option<bool> Argparse::AddFlag(char sym, const char *name, const char *help)
+{
+    return Option<bool>(m_Parser, add_flag(m_Parser, sym, name, help));
+};
 
-Argparse::Argparse()
+Option<const char *> Argparse::AddArg(char sym, const char *name, int required, int nargs, const char *default_value, const char *help)
+{
+    return Option<const char *>(m_Parser, add_arg(m_Parser, sym, name, required, nargs, default_value, help));
+};
+
+Option<const char *> Argparse::AddKwarg(char sym, const char *name, int required, const char *default_value, const char *help)
 {
-    init_parser(&m_Parser, "", "", "", "");
+    return Option<const char *>(m_Parser, add_kwarg(m_Parser, sym, name, required, default_value, help));
 };
 
-Argparse::Argparse(std::string program, std::string usage, std::string description, std::string epilog)
+Argparse::~Argparse()
 {
-    init_parser(&m_Parser, program.c_str(), usage.c_str(), description.c_str(), epilog.c_str());
+    if (!m_Parser)
+        return;
+    free_parser(m_Parser);
+    myargs_heap_free(m_Parser);
 }
+#pragma endregion // DEFINATIONS
 
-void Argparse::Help(int description, int usage, int epilog, int group)
+#pragma region SCHEMA
+
+#ifdef MYARGS_CXX17
+
+/**
+ * Compile-time option schemas for programs with a fixed set of options.
+ *
+ * The lookup tables are built by the compiler, parsing is one pass over argv
+ * with no registration and no heap allocation, and values are converted
+ * straight into a typed result.
+ *
+ * Example usage:
+ * constexpr auto spec = myargs::schema(myargs::flag('v', "verbose", "Enable verbose mode"),
+ *                                      myargs::kwarg<int>('c', "count", "Number of times", 1));
+ *
+ * auto result = spec.Parse(argc, argv);
+ * if (!result)
+ *     fprintf(stderr, "Invalid argument: %s\n", result.error);
+ * bool verbose = result.get<0>();
+ * int count = result.get<1>();
+ */
+namespace myargs
 {
-    print_help(&m_Parser, description, usage, epilog, group);
-};
 
-const char *Argparse::GetArg(const char *name)
+/**
+ * Hashes the first length bytes of a name, identical to myargs_hash.
+ */
+constexpr unsigned int hash(const char *name, size_t length)
 {
-    return get_arg(&m_Parser, name);
-};
+    unsigned int hash = 2166136261u;
+    for (size_t i = 0; i < length; i++)
+    {
+        hash ^= (unsigned char)name[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
 
-int Argparse::GetFlag(const char *name)
+constexpr size_t length(const char *str)
 {
-    return get_flag(&m_Parser, name);
-};
+    size_t length = 0;
+    while (str[length] != '\0')
+        length++;
+    return length;
+}
 
-const char *Argparse::GetKwarg(const char *name)
+/**
+ * The smallest power of two, at least 16, that keeps an index of count names at most half full.
+ */
+constexpr size_t index_size(size_t count)
 {
-    return get_kwarg(&m_Parser, name);
-};
+    size_t size = 16;
+    while (size < count * 2)
+        size *= 2;
+    return size;
+}
 
-void Argparse::Parse(int argc, char *argv[])
+/**
+ * Describes one option of a schema; T is the type its value is converted to.
+ */
+template <typename T>
+struct Spec
 {
-    parse_args(&m_Parser, argc, argv);
+    Type type;         /**< The type of the argument (FLAG, KWARG, ARG). */
+    char sym;          /**< The short symbol for the argument, or 0. */
+    const char *name;  /**< The long name of the argument. */
+    const char *help;  /**< The help message for the argument. */
+    bool required;     /**< Whether the argument is required. */
+    T def_val;         /**< The value used when the argument is absent. */
 };
 
-void Argparse::AddFlag(char sym, const char *name, const char *help)
+constexpr Spec<bool> flag(char sym, const char *name, const char *help = "")
 {
-    add_flag(&m_Parser, sym, name, help);
-};
+    return Spec<bool>{FLAG, sym, name, help, false, false};
+}
 
-void Argparse::AddArg(char sym, const char *name, int required, int nargs, const char *default_value, const char *help)
+template <typename T>
+constexpr Spec<T> kwarg(char sym, const char *name, const char *help = "", T def_val = T(), bool required = false)
 {
-    add_arg(&m_Parser, sym, name, required, nargs, default_value, help);
+    return Spec<T>{KWARG, sym, name, help, required, def_val};
+}
+
+template <typename T>
+constexpr Spec<T> arg(char sym, const char *name, const char *help = "", T def_val = T(), bool required = true)
+{
+    return Spec<T>{ARG, sym, name, help, required, def_val};
+}
+
+inline bool convert(const char *text, const char *&value)
+{
+    value = text;
+    return true;
+}
+
+inline bool convert(const char *text, bool &value)
+{
+    if (strcmp(text, "true") == 0 || strcmp(text, "1") == 0 || strcmp(text, "yes") == 0)
+        value = true;
+    else if (strcmp(text, "false") == 0 || strcmp(text, "0") == 0 || strcmp(text, "no") == 0)
+        value = false;
+    else
+        return false;
+    return true;
+}
+
+inline bool convert(const char *text, long long &value)
+{
+    char *end;
+    errno = 0;
+    value = strtoll(text, &end, 0);
+    return *text != '\0' && *end == '\0' && errno == 0;
+}
+
+inline bool convert(const char *text, long &value)
+{
+    long long converted;
+    if (!convert(text, converted) || converted < LONG_MIN || converted > LONG_MAX)
+        return false;
+    value = (long)converted;
+    return true;
+}
+
+inline bool convert(const char *text, int &value)
+{
+    long long converted;
+    if (!convert(text, converted) || converted < INT_MIN || converted > INT_MAX)
+        return false;
+    value = (int)converted;
+    return true;
+}
+
+inline bool convert(const char *text, double &value)
+{
+    char *end;
+    errno = 0;
+    value = strtod(text, &end);
+    return *text != '\0' && *end == '\0' && errno == 0;
+}
+
+/**
+ * The typed values produced by Schema::Parse, in schema order.
+ */
+template <typename... T>
+struct Result
+{
+    std::tuple<T...> values;       /**< The converted values, defaults where absent. */
+    bool seen[sizeof...(T)];       /**< Whether each option appeared on the command line. */
+    const char *error;             /**< The offending token or missing option name, or nullptr. */
+
+    template <size_t I>
+    const typename std::tuple_element<I, std::tuple<T...>>::type &get() const { return std::get<I>(values); }
+
+    template <size_t I>
+    bool has() const { return seen[I]; }
+
+    explicit operator bool() const { return error == nullptr; }
 };
 
-void Argparse::AddKwarg(char sym, const char *name, int required, const char *default_value, const char *help)
+template <typename... T>
+class Schema
 {
-    add_kwarg(&m_Parser, sym, name, required, default_value, help);
+    static_assert(sizeof...(T) > 0, "a schema needs at least one option");
+
+public:
+    static constexpr size_t Count = sizeof...(T);
+    static constexpr size_t IndexSize = index_size(Count);
+
+private:
+    struct Entry
+    {
+        Type type;
+        char sym;
+        const char *name;
+        size_t length;
+        unsigned int hash;
+        bool required;
+    };
+
+    std::tuple<Spec<T>...> m_Specs;
+    Entry m_Entries[Count]{};
+    short m_Syms[256]{};        // index + 1, 0 if unused
+    short m_Index[IndexSize]{}; // index + 1, 0 if empty
+
+public:
+    constexpr Schema(Spec<T>... specs) : m_Specs(specs...)
+    {
+        const Entry entries[] = {Entry{specs.type, specs.sym, specs.name, length(specs.name), hash(specs.name, length(specs.name)), specs.required}...};
+        for (size_t i = 0; i < Count; i++)
+        {
+            m_Entries[i] = entries[i];
+            if (entries[i].sym && m_Syms[(unsigned char)entries[i].sym] == 0)
+                m_Syms[(unsigned char)entries[i].sym] = (short)(i + 1);
+            if (Find(entries[i].name, entries[i].length) >= 0)
+                continue;
+
+            size_t slot = entries[i].hash & (IndexSize - 1);
+            while (m_Index[slot] != 0)
+                slot = (slot + 1) & (IndexSize - 1);
+            m_Index[slot] = (short)(i + 1);
+        }
+    }
+
+    /**
+     * Looks up an option by its long name, which need not be NUL terminated.
+     *
+     * @return The position of the option in the schema, or -1.
+     */
+    constexpr int Find(const char *name, size_t length) const
+    {
+        unsigned int h = hash(name, length);
+        for (size_t slot = h & (IndexSize - 1); m_Index[slot] != 0; slot = (slot + 1) & (IndexSize - 1))
+        {
+            const Entry &entry = m_Entries[m_Index[slot] - 1];
+            if (entry.hash != h || entry.length != length)
+                continue;
+            size_t j = 0;
+            while (j < length && entry.name[j] == name[j])
+                j++;
+            if (j == length)
+                return m_Index[slot] - 1;
+        }
+        return -1;
+    }
+
+    /**
+     * Looks up an option by its short symbol.
+     *
+     * @return The position of the option in the schema, or -1.
+     */
+    constexpr int FindSym(char sym) const
+    {
+        return m_Syms[(unsigned char)sym] - 1;
+    }
+
+    const char *Name(size_t i) const { return m_Entries[i].name; }
+
+    Result<T...> Parse(int argc, const char *const argv[]) const
+    {
+        Result<T...> result{Defaults(std::index_sequence_for<T...>{}), {}, nullptr};
+
+        for (int i = 1; i < argc && !result.error; i++)
+        {
+            const char *token = argv[i];
+            const char *arg = token;
+            switch (token[0] == '-' ? (token[1] == '-' ? 2 : 1) : 0)
+            {
+            case 2: // --name or --name=value
+            case 0: // name=value
+            {
+                arg += token[0] == '-' ? 2 : 0;
+                const char *value = strchr(arg, '=');
+                int j = Find(arg, value ? (size_t)(value - arg) : strlen(arg));
+                // an unknown long option is an error, as in parse_args; a bare token may be a value
+                if ((j < 0 && token[0] == '-') || (j >= 0 && !Store(result, j, value ? value + 1 : nullptr, std::index_sequence_for<T...>{})))
+                    result.error = token;
+                break;
+            }
+            case 1: // -abc, -c5 or -abc=value, read as myargs_take_bundle reads them
+            {
+                arg += 1;
+                const char *value = strchr(arg, '=');
+                const char *end = value ? value : arg + strlen(arg);
+                int taker = -1;
+                for (; arg < end && !result.error; arg++)
+                {
+                    int j = FindSym(*arg);
+                    if (j < 0)
+                    {
+                        result.error = token;
+                    }
+                    else if (m_Entries[j].type == FLAG)
+                    {
+                        Store(result, j, nullptr, std::index_sequence_for<T...>{});
+                    }
+                    else if (m_Entries[j].type != ARG && !value)
+                    {
+                        // the first option that takes a value takes the rest of the token
+                        if (!Store(result, j, arg + 1 < end ? arg + 1 : nullptr, std::index_sequence_for<T...>{}))
+                            result.error = token;
+                        break;
+                    }
+                    else if (m_Entries[j].type != ARG)
+                    {
+                        taker = j;
+                    }
+                }
+                // with '=', the value goes only to the last option that takes one
+                if (taker >= 0 && !result.error && !Store(result, taker, value + 1, std::index_sequence_for<T...>{}))
+                    result.error = token;
+                break;
+            }
+            }
+        }
+
+        for (size_t i = 0; i < Count && !result.error; i++)
+        {
+            if (m_Entries[i].required && !result.seen[i])
+                result.error = m_Entries[i].name;
+        }
+        return result;
+    }
+
+private:
+    template <size_t... I>
+    constexpr std::tuple<T...> Defaults(std::index_sequence<I...>) const
+    {
+        return std::tuple<T...>(std::get<I>(m_Specs).def_val...);
+    }
+
+    template <size_t I>
+    bool StoreOne(Result<T...> &result, const char *value) const
+    {
+        auto &slot = std::get<I>(result.values);
+        result.seen[I] = true;
+        if constexpr (std::is_same<typename std::decay<decltype(slot)>::type, bool>::value)
+        {
+            if (m_Entries[I].type == FLAG)
+            {
+                slot = true;
+                return true;
+            }
+        }
+        return value && convert(value, slot);
+    }
+
+    // expands to a jump on j over every option of the schema
+    template <size_t... I>
+    bool Store(Result<T...> &result, int j, const char *value, std::index_sequence<I...>) const
+    {
+        bool stored = false;
+        (void)((j == (int)I && (stored = StoreOne<I>(result, value), true)) || ...);
+        return stored;
+    }
 };
 
-Argparse::~Argparse()
+template <typename... T>
+constexpr Schema<T...> schema(Spec<T>... specs)
 {
-    free_parser(&m_Parser);
+    return Schema<T...>(specs...);
 }
-#pragma endregion // DEFINATIONS
+
+} // namespace myargs
+
+#endif // MYARGS_CXX17
+
+#pragma endregion // SCHEMA
 
 #endif // __cplusplus
 